@@ -0,0 +1,125 @@
+#ifndef Adjoint_H
+#define Adjoint_H
+#include<vector>
+#include<memory>
+#include<cmath>
+#include<cstdint>
+#include<cstddef>
+#include<algorithm>
+
+//One recorded operation: up to two parents and the partial derivative with respect to each.
+//Unused parent slots point at node 0, a sink whose adjoint is never read.
+struct TapeNode
+{
+    double Partial[2];
+    std::uint32_t Parent[2];
+};
+//Reverse-mode tape. Nodes are stored in fixed-size blocks that are kept when the tape is rewound, so once the
+//tape has grown to the size of a recording, recording it again allocates nothing.
+class Tape
+{
+public:
+    static constexpr std::size_t BlockBits{16};
+    static constexpr std::size_t BlockSize{std::size_t{1}<<BlockBits};
+    Tape(){Clear();};
+    std::uint32_t Push(std::uint32_t p0,double d0,std::uint32_t p1,double d1)
+    {
+        if(Size==Blocks.size()*BlockSize)Blocks.emplace_back(new TapeNode[BlockSize]);
+        Blocks[Size>>BlockBits][Size&(BlockSize-1)]=TapeNode{{d0,d1},{p0,p1}};
+        return static_cast<std::uint32_t>(Size++);
+    };
+    std::size_t Mark()const{return Size;};
+    //Drops everything recorded after Position; the storage is kept for the next recording.
+    void Rewind(std::size_t Position)
+    {
+        //Before the first Propagate there may be fewer adjoints than Position, and nothing to clear.
+        std::size_t End{std::min(Adjoints.size(),Size)};
+        if(Position<End)std::fill(Adjoints.begin()+Position,Adjoints.begin()+End,0.0);
+        Size=Position;
+    };
+    void Clear()
+    {
+        Size=0;
+        std::fill(Adjoints.begin(),Adjoints.end(),0.0);
+        Push(0,0.0,0,0.0);
+    };
+    //Adds Seed to the adjoint of Output and sweeps back to Position, accumulating into every earlier node.
+    void Propagate(std::uint32_t Output,double Seed,std::size_t Position=1)
+    {
+        if(Adjoints.size()<Size)Adjoints.resize(Blocks.size()*BlockSize,0.0);
+        Adjoints[Output]+=Seed;
+        for(std::size_t i=Size;i-->Position;)
+        {
+            double a{Adjoints[i]};
+            if(a==0.0)continue;
+            const TapeNode&Node{Blocks[i>>BlockBits][i&(BlockSize-1)]};
+            Adjoints[Node.Parent[0]]+=Node.Partial[0]*a;
+            Adjoints[Node.Parent[1]]+=Node.Partial[1]*a;
+        };
+    };
+    //Checkpointed step for long loops: propagate one sub-computation (e.g. one Monte Carlo path) recorded
+    //since Position into the nodes before it, then discard it so the tape never holds more than one path.
+    void PropagateAndRewind(std::uint32_t Output,double Seed,std::size_t Position)
+    {
+        Propagate(Output,Seed,Position);
+        Rewind(Position);
+    };
+    //After a checkpointed loop the nodes recorded before it hold the accumulated adjoints of all steps;
+    //this pushes them on to the inputs.
+    void PropagateRecorded(){Propagate(0,0.0);};
+    double AdjointOf(std::uint32_t Index)const{return Index<Adjoints.size()?Adjoints[Index]:0.0;};
+    std::size_t Nodes()const{return Size;};
+    std::size_t Capacity()const{return Blocks.size()*BlockSize;};
+private:
+    std::vector<std::unique_ptr<TapeNode[]>>Blocks;
+    std::vector<double>Adjoints;
+    std::size_t Size{0};
+};
+inline Tape*&ActiveTape()
+{
+    thread_local Tape*Current{nullptr};
+    return Current;
+};
+//Active number recorded on the thread's active tape. Constructing from a double gives a constant (node 0);
+//Register makes it an input whose adjoint can be read back after propagation.
+struct Adjoint
+{
+    double Value{0.0};
+    std::uint32_t Index{0};
+    Adjoint()=default;
+    Adjoint(double v):Value{v}{};
+    Adjoint(double v,std::uint32_t i):Value{v},Index{i}{};
+    void Register(){Index=ActiveTape()->Push(0,0.0,0,0.0);};
+    double Derivative()const{return ActiveTape()->AdjointOf(Index);};
+    Adjoint&operator+=(const Adjoint&b){return *this=*this+b;};
+    Adjoint&operator-=(const Adjoint&b){return *this=*this-b;};
+    Adjoint&operator*=(const Adjoint&b){return *this=*this*b;};
+    Adjoint&operator/=(const Adjoint&b){return *this=*this/b;};
+    friend Adjoint operator+(const Adjoint&a,const Adjoint&b){return {a.Value+b.Value,ActiveTape()->Push(a.Index,1.0,b.Index,1.0)};};
+    friend Adjoint operator-(const Adjoint&a,const Adjoint&b){return {a.Value-b.Value,ActiveTape()->Push(a.Index,1.0,b.Index,-1.0)};};
+    friend Adjoint operator*(const Adjoint&a,const Adjoint&b){return {a.Value*b.Value,ActiveTape()->Push(a.Index,b.Value,b.Index,a.Value)};};
+    friend Adjoint operator/(const Adjoint&a,const Adjoint&b)
+    {
+        double q{a.Value/b.Value};
+        return {q,ActiveTape()->Push(a.Index,1.0/b.Value,b.Index,-q/b.Value)};
+    };
+    friend Adjoint operator-(const Adjoint&a){return {-a.Value,ActiveTape()->Push(a.Index,-1.0,0,0.0)};};
+    friend bool operator<(const Adjoint&a,const Adjoint&b){return a.Value<b.Value;};
+    friend bool operator>(const Adjoint&a,const Adjoint&b){return a.Value>b.Value;};
+};
+inline Adjoint exp(const Adjoint&a)
+{
+    double e{std::exp(a.Value)};
+    return {e,ActiveTape()->Push(a.Index,e,0,0.0)};
+};
+inline Adjoint log(const Adjoint&a){return {std::log(a.Value),ActiveTape()->Push(a.Index,1.0/a.Value,0,0.0)};};
+inline Adjoint sqrt(const Adjoint&a)
+{
+    double s{std::sqrt(a.Value)};
+    return {s,ActiveTape()->Push(a.Index,0.5/s,0,0.0)};
+};
+inline Adjoint max(const Adjoint&a,const Adjoint&b){return a.Value>=b.Value?a:b;};
+inline double ValueOf(double x){return x;};
+inline double ValueOf(const Adjoint&x){return x.Value;};
+
+#endif
@@ -0,0 +1,351 @@
+#ifndef Aggregation_H
+#define Aggregation_H
+#include<vector>
+#include<array>
+#include<string_view>
+#include<initializer_list>
+#include<limits>
+#include<algorithm>
+#include<bit>
+#include<cstdint>
+#include<cstddef>
+#include"ZeroCoupnBond.h"
+#include"BlackScholes.h"
+#include"Symbols.h"
+#include"Parallel.h"
+#include"Summation.h"
+
+//The instrument categories of "Some Mechanics of C++" (main.cc, Enum Classes).
+enum class Bond
+{
+    Government,
+    Corporate,
+    Municipal,
+    Convertible
+};
+enum class Futures_Contract
+{
+    Gold,
+    Silver,
+    Oil,
+    Natural_Gas,
+    Wheat,
+    Corn
+};
+enum class Options_Contract
+{
+    European,
+    American,
+    Bermudan,
+    Asian
+};
+//Dictionary of an enum class: the names its codes stand for, in declaration order.
+template<typename E>
+struct EnumTraits;
+template<>
+struct EnumTraits<Bond>
+{
+    static constexpr std::array<std::string_view,4>Names{"Government","Corporate","Municipal","Convertible"};
+};
+template<>
+struct EnumTraits<Futures_Contract>
+{
+    static constexpr std::array<std::string_view,6>Names{"Gold","Silver","Oil","Natural_Gas","Wheat","Corn"};
+};
+template<>
+struct EnumTraits<Options_Contract>
+{
+    static constexpr std::array<std::string_view,4>Names{"European","American","Bermudan","Asian"};
+};
+//Dictionary-encoded column of one enum class: one byte per row, the enumerator's position, or Null (the
+//enumerator count) on rows where the column does not apply. The column type carries E, so a filter or a
+//group-by on it only takes that enum class, as with the enum classes themselves.
+template<typename E>
+struct EnumColumn
+{
+    static constexpr std::size_t Size{EnumTraits<E>::Names.size()};
+    static constexpr std::uint8_t Null{static_cast<std::uint8_t>(Size)};
+    std::vector<std::uint8_t>Code{};
+    void Push(E Value){Code.push_back(static_cast<std::uint8_t>(Value));};
+    void PushNull(){Code.push_back(Null);};
+};
+
+//Count, sum, min and max of a measure over one group.
+struct GroupStats
+{
+    std::uint64_t Count{0};
+    double Sum{0.0};
+    double Min{std::numeric_limits<double>::infinity()};
+    double Max{-std::numeric_limits<double>::infinity()};
+    double Mean()const{return Count?Sum/Count:0.0;};
+};
+//Row filter, one bit per row. Filters combine with &= and |= and are built by Where().
+struct FilterBitmap
+{
+    std::size_t Rows;
+    std::vector<std::uint64_t>Words;
+    explicit FilterBitmap(std::size_t Rows,bool All=false):Rows{Rows},Words((Rows+63)/64,All?~0ull:0ull)
+    {
+        if(All&&Rows%64)Words.back()=(1ull<<(Rows%64))-1;
+    };
+    FilterBitmap&operator&=(const FilterBitmap&Other)
+    {
+        for(std::size_t w=0;w<Words.size();++w)Words[w]&=Other.Words[w];
+        return *this;
+    };
+    FilterBitmap&operator|=(const FilterBitmap&Other)
+    {
+        for(std::size_t w=0;w<Words.size();++w)Words[w]|=Other.Words[w];
+        return *this;
+    };
+    std::size_t Count()const
+    {
+        std::size_t n{0};
+        for(std::uint64_t w:Words)n+=static_cast<std::size_t>(std::popcount(w));
+        return n;
+    };
+    bool Test(std::size_t Row)const{return (Words[Row/64]>>(Row%64))&1;};
+};
+//Rows whose code is one of Values: a 64-bit set of codes tested with a shift, 64 rows to a word.
+template<typename E>
+FilterBitmap Where(const EnumColumn<E>&Column,std::initializer_list<E>Values)
+{
+    std::uint64_t Set{0};
+    for(E Value:Values)Set|=1ull<<static_cast<unsigned>(Value);
+    FilterBitmap Filter{Column.Code.size()};
+    const std::uint8_t*Code{Column.Code.data()};
+    for(std::size_t w=0;w<Filter.Words.size();++w)
+    {
+        std::size_t Begin{64*w},End{std::min(Filter.Rows,Begin+64)};
+        std::uint64_t Bits{0};
+        for(std::size_t i=Begin;i<End;++i)Bits|=((Set>>Code[i])&1)<<(i-Begin);
+        Filter.Words[w]=Bits;
+    };
+    return Filter;
+};
+//Rows with a dictionary code equal to Code, e.g. one desk.
+inline FilterBitmap Where(const std::vector<std::uint32_t>&Column,std::uint32_t Code)
+{
+    FilterBitmap Filter{Column.size()};
+    for(std::size_t w=0;w<Filter.Words.size();++w)
+    {
+        std::size_t Begin{64*w},End{std::min(Filter.Rows,Begin+64)};
+        std::uint64_t Bits{0};
+        for(std::size_t i=Begin;i<End;++i)Bits|=static_cast<std::uint64_t>(Column[i]==Code)<<(i-Begin);
+        Filter.Words[w]=Bits;
+    };
+    return Filter;
+};
+//Rows with Low <= x < High. Both compares are evaluated (& not &&) so the word vectorises.
+inline FilterBitmap Where(const std::vector<double>&Column,double Low,double High)
+{
+    FilterBitmap Filter{Column.size()};
+    for(std::size_t w=0;w<Filter.Words.size();++w)
+    {
+        std::size_t Begin{64*w},End{std::min(Filter.Rows,Begin+64)};
+        std::uint64_t Bits{0};
+        for(std::size_t i=Begin;i<End;++i)Bits|=static_cast<std::uint64_t>((Column[i]>=Low)&(Column[i]<High))<<(i-Begin);
+        Filter.Words[w]=Bits;
+    };
+    return Filter;
+};
+
+//Rows per block of a group-by. A block's key, measure and filter bytes stay in L1 while it is aggregated.
+constexpr std::size_t AggregateBlock{2048};
+static_assert(AggregateBlock<=SumBlock);
+//Runs BlockStats(Begin,End,Out) on each block of AggregateBlock rows, over threads, into per-block dense
+//accumulators of Groups entries, then folds the blocks in row order with compensated sums. As long as
+//BlockStats fixes its own order of additions, e.g. with the explicit lanes of SumOneBlock, the order of every
+//addition depends only on the row count, so reports are bit-identical for any thread count and SIMD width.
+template<typename Function>
+std::vector<GroupStats>AggregateBlocks(std::size_t Rows,std::size_t Groups,Function&&BlockStats,unsigned Threads)
+{
+    std::size_t Blocks{(Rows+AggregateBlock-1)/AggregateBlock};
+    std::vector<GroupStats>Partial(Blocks*Groups);
+    ParallelFor(Blocks,[&](std::size_t First,std::size_t Last)
+    {
+        for(std::size_t b=First;b<Last;++b)BlockStats(b*AggregateBlock,std::min(Rows,(b+1)*AggregateBlock),Partial.data()+b*Groups);
+    },Threads,1);
+    std::vector<GroupStats>Result(Groups);
+    std::vector<NeumaierAccumulator>Sum(Groups);
+    for(std::size_t b=0;b<Blocks;++b)for(std::size_t g=0;g<Groups;++g)
+    {
+        const GroupStats&p{Partial[b*Groups+g]};
+        Result[g].Count+=p.Count;
+        Sum[g].Add(p.Sum);
+        Result[g].Min=std::min(Result[g].Min,p.Min);
+        Result[g].Max=std::max(Result[g].Max,p.Max);
+    };
+    for(std::size_t g=0;g<Groups;++g)Result[g].Sum=Sum[g].Total();
+    return Result;
+};
+//One byte per row of a block, 1 where the filter (if any) keeps the row.
+inline void ExpandFilter(const FilterBitmap*Filter,std::size_t Begin,std::size_t End,std::uint8_t*Keep)
+{
+    if(!Filter)
+    {
+        std::fill(Keep,Keep+(End-Begin),std::uint8_t{1});
+        return;
+    };
+    //Blocks start on a word boundary, so each word fills 64 bytes of Keep.
+    const std::uint64_t*Words{Filter->Words.data()+Begin/64};
+    const std::size_t n{End-Begin};
+    for(std::size_t w=0;w<(n+63)/64;++w)
+    {
+        std::uint8_t Bytes[64];
+        for(std::size_t b=0;b<64;++b)Bytes[b]=static_cast<std::uint8_t>((Words[w]>>b)&1);
+        std::copy(Bytes,Bytes+std::min<std::size_t>(64,n-64*w),Keep+64*w);
+    };
+};
+//Group-by on an enum column. With a handful of codes the sums and counts are enum-indexed and every group
+//is updated branch-free for each row in one pass over the block, so they vectorise instead of scattering;
+//the sums use SumOneBlock's explicit compensated lanes, so they do not depend on the vector width. Min and
+//max do not vectorise as reductions, so they scatter into four interleaved copies of the accumulators instead, one
+//per row mod 4, which keeps consecutive rows of one group off each other's store. Rows with the Null code
+//are left out.
+template<typename E>
+std::array<GroupStats,EnumColumn<E>::Size>GroupBy(const EnumColumn<E>&Key,const std::vector<double>&Measure,const FilterBitmap*Filter=nullptr,unsigned Threads=ThreadCount())
+{
+    constexpr std::size_t Groups{EnumColumn<E>::Size};
+    const std::uint8_t*Code{Key.Code.data()};
+    const double*Value{Measure.data()};
+    std::vector<GroupStats>All{AggregateBlocks(Measure.size(),Groups,[&](std::size_t Begin,std::size_t End,GroupStats*Out)
+    {
+        std::uint8_t Keep[AggregateBlock];
+        ExpandFilter(Filter,Begin,End,Keep);
+        //The block's codes with filtered-out rows as Null, as bytes for the scatter and as doubles so the
+        //masked pass compares and blends in double lanes only.
+        std::uint8_t Row[AggregateBlock];
+        double Slot[AggregateBlock];
+        const std::size_t n{End-Begin};
+        const double*x{Value+Begin};
+        for(std::size_t i=0;i<n;++i)
+        {
+            Row[i]=Keep[i]?Code[Begin+i]:EnumColumn<E>::Null;
+            Slot[i]=Row[i];
+        };
+        //Every group's masked values in SumOneBlock's compensated lanes, row i in lane i%SumLanes, all groups
+        //in one pass. Counts are whole numbers well below 2^53, so exact in any order.
+        double Sum[Groups][SumLanes]{},Carry[Groups][SumLanes]{},Count[Groups][SumLanes]{};
+        auto Add=[&](std::size_t i,std::size_t Lane)
+        {
+            for(std::size_t g=0;g<Groups;++g)
+            {
+                bool Hit{Slot[i]==double(g)};
+                AddToLane<true>(Sum[g][Lane],Carry[g][Lane],Hit?x[i]:0.0);
+                Count[g][Lane]+=Hit?1.0:0.0;
+            };
+        };
+        std::size_t First{0};
+        for(;First+SumLanes<=n;First+=SumLanes)
+        {
+            #pragma omp simd
+            for(std::size_t Lane=0;Lane<SumLanes;++Lane)Add(First+Lane,Lane);
+        };
+        for(std::size_t Lane=0;First+Lane<n;++Lane)Add(First+Lane,Lane);
+        for(std::size_t g=0;g<Groups;++g)
+        {
+            Out[g].Sum=FoldLanes<true>(Sum[g],Carry[g]).Total();
+            double Total{0.0};
+            for(double c:Count[g])Total+=c;
+            Out[g].Count=static_cast<std::uint64_t>(Total);
+        };
+        const double Infinity{std::numeric_limits<double>::infinity()};
+        double Min[4][Groups+1],Max[4][Groups+1];
+        for(std::size_t l=0;l<4;++l)for(std::size_t g=0;g<=Groups;++g)
+        {
+            Min[l][g]=Infinity;
+            Max[l][g]=-Infinity;
+        };
+        std::size_t i{0};
+        for(;i+4<=n;i+=4)for(std::size_t l=0;l<4;++l)
+        {
+            double&Low{Min[l][Row[i+l]]},&High{Max[l][Row[i+l]]};
+            Low=x[i+l]<Low?x[i+l]:Low;
+            High=x[i+l]>High?x[i+l]:High;
+        };
+        for(;i<n;++i)
+        {
+            Min[0][Row[i]]=std::min(Min[0][Row[i]],x[i]);
+            Max[0][Row[i]]=std::max(Max[0][Row[i]],x[i]);
+        };
+        for(std::size_t g=0;g<Groups;++g)
+        {
+            Out[g].Min=std::min({Min[0][g],Min[1][g],Min[2][g],Min[3][g]});
+            Out[g].Max=std::max({Max[0][g],Max[1][g],Max[2][g],Max[3][g]});
+        };
+    },Threads)};
+    std::array<GroupStats,Groups>Result{};
+    std::copy(All.begin(),All.end(),Result.begin());
+    return Result;
+};
+//Group-by on a dictionary column crossed with an enum column, into [Outer*E's size+Inner]: too many groups
+//for one pass each, so rows scatter into the block's dense accumulators.
+template<typename E>
+std::vector<GroupStats>GroupBy(const std::vector<std::uint32_t>&Outer,std::size_t OuterGroups,const EnumColumn<E>&Inner,const std::vector<double>&Measure,
+    const FilterBitmap*Filter=nullptr,unsigned Threads=ThreadCount())
+{
+    constexpr std::size_t Size{EnumColumn<E>::Size};
+    const std::uint32_t*First{Outer.data()};
+    const std::uint8_t*Second{Inner.Code.data()};
+    const double*Value{Measure.data()};
+    return AggregateBlocks(Measure.size(),OuterGroups*Size,[&](std::size_t Begin,std::size_t End,GroupStats*Out)
+    {
+        std::uint8_t Keep[AggregateBlock];
+        ExpandFilter(Filter,Begin,End,Keep);
+        for(std::size_t i=Begin;i<End;++i)
+        {
+            if(!Keep[i-Begin]||Second[i]==EnumColumn<E>::Null)continue;
+            GroupStats&s{Out[First[i]*Size+Second[i]]};
+            ++s.Count;
+            s.Sum+=Value[i];
+            s.Min=std::min(s.Min,Value[i]);
+            s.Max=std::max(s.Max,Value[i]);
+        };
+    },Threads);
+};
+
+//Priced positions as columns. Each row is a bond, a futures contract or an option: its category sits in the
+//column for its own enum class and the other two hold Null. Desks are interned into dense codes. Value is
+//quantity times the priced result of the row's ZeroCouponStruct or OptionStruct, or of the futures price.
+struct PositionTable
+{
+    EnumColumn<Bond>BondType{};
+    EnumColumn<Futures_Contract>FuturesType{};
+    EnumColumn<Options_Contract>OptionType{};
+    SymbolTable Desks{};
+    std::vector<std::uint32_t>Desk{};
+    std::vector<double>Quantity{};
+    std::vector<double>Value{};
+    void AddBond(std::string_view DeskName,Bond Type,double Amount,const ZeroCouponStruct&Priced)
+    {
+        BondType.Push(Type);
+        FuturesType.PushNull();
+        OptionType.PushNull();
+        Add(DeskName,Amount,Amount*Priced.Price);
+    };
+    void AddFuture(std::string_view DeskName,Futures_Contract Type,double Amount,double Price)
+    {
+        BondType.PushNull();
+        FuturesType.Push(Type);
+        OptionType.PushNull();
+        Add(DeskName,Amount,Amount*Price);
+    };
+    void AddOption(std::string_view DeskName,Options_Contract Type,double Amount,const OptionStruct&Priced)
+    {
+        BondType.PushNull();
+        FuturesType.PushNull();
+        OptionType.Push(Type);
+        Add(DeskName,Amount,Amount*Priced.Price);
+    };
+    std::size_t Size()const{return Value.size();};
+private:
+    void Add(std::string_view DeskName,double Amount,double Priced)
+    {
+        Desk.push_back(Desks.Intern(DeskName));
+        Quantity.push_back(Amount);
+        Value.push_back(Priced);
+    };
+};
+
+#endif
@@ -0,0 +1,134 @@
+#include"Arena.h"
+#include"ZeroCoupnBond.h"
+#include<memory_resource>
+#include<string>
+#include<string_view>
+#include<chrono>
+//A loaded trade: identifiers too long for the short-string buffer, so each trade costs two heap blocks
+//plus its share of the vector, which is what the loaders do today.
+struct BondTrade
+{
+    using allocator_type=std::pmr::polymorphic_allocator<>;
+    std::pmr::string Identifier;
+    std::pmr::string Counterparty;
+    ZeroCouponStruct Bond;
+    BondTrade(std::string_view Id,std::string_view Name,const ZeroCouponStruct&Zero,allocator_type Allocator={})
+        :Identifier{Id,Allocator},Counterparty{Name,Allocator},Bond{Zero}{};
+    BondTrade(const BondTrade&Other,allocator_type Allocator)
+        :Identifier{Other.Identifier,Allocator},Counterparty{Other.Counterparty,Allocator},Bond{Other.Bond}{};
+    BondTrade(BondTrade&&Other,allocator_type Allocator)
+        :Identifier{std::move(Other.Identifier),Allocator},Counterparty{std::move(Other.Counterparty),Allocator},Bond{Other.Bond}{};
+};
+double Seconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+};
+struct RunTimes
+{
+    double Load{0.0},Price{0.0},Free{0.0},Value{0.0};
+};
+//The parsed input file: fixed-width identifier and counterparty fields, one row per trade.
+struct TradeFile
+{
+    static constexpr std::size_t Width{24};
+    std::vector<char>Ids,Names;
+    explicit TradeFile(std::size_t Count):Ids(Count*Width),Names(Count*Width)
+    {
+        for(std::size_t i=0;i<Count;++i)
+        {
+            std::snprintf(Ids.data()+i*Width,Width,"ZCB-GOVT-%012zu",i);
+            std::snprintf(Names.data()+i*Width,Width,"COUNTERPARTY-%06zu",i%5000);
+        };
+    };
+    std::string_view Id(std::size_t i)const{return Ids.data()+i*Width;};
+    std::string_view Name(std::size_t i)const{return Names.data()+i*Width;};
+};
+//Loads every trade in File into a book on Book, prices them into scratch on Scratch, then drops both.
+RunTimes LoadThenPrice(const TradeFile&File,std::pmr::memory_resource*Book,std::pmr::memory_resource*Scratch)
+{
+    RunTimes Times{};
+    std::size_t Count{File.Ids.size()/TradeFile::Width};
+    auto Start{std::chrono::steady_clock::now()};
+    auto*Trades{new std::pmr::vector<BondTrade>{Book}};
+    for(std::size_t i=0;i<Count;++i)Trades->emplace_back(File.Id(i),File.Name(i),ZeroCouponStruct{100.0,0.01+1e-8*i,1.0+i%30,0.0});
+    Times.Load=Seconds(Start);
+    Start=std::chrono::steady_clock::now();
+    std::pmr::vector<double>Prices{Scratch};
+    std::pmr::vector<std::size_t>Order{Scratch};
+    for(auto&Trade:*Trades)
+    {
+        ZeroCouponBond(Trade.Bond);
+        Prices.push_back(Trade.Bond.Price);
+        Order.push_back(Prices.size()-1);
+    };
+    for(double Price:Prices)Times.Value+=Price;
+    Times.Price=Seconds(Start);
+    Start=std::chrono::steady_clock::now();
+    delete Trades;
+    Times.Free=Seconds(Start);
+    return Times;
+};
+void Report(const char*Name,const RunTimes&Times,const AllocationCounters&Counters,std::size_t System)
+{
+    std::cout<<std::setw(22)<<std::left<<Name<<std::right<<std::setw(10)<<1e3*Times.Load<<std::setw(10)<<1e3*Times.Price
+        <<std::setw(10)<<1e3*Times.Free<<std::setw(13)<<Counters.Allocations<<std::setw(11)<<System<<"\n";
+};
+int main()
+{
+    const std::size_t Count{1000000};
+    const int Batches{3};
+    TradeFile File{Count};
+    std::cout<<std::setprecision(4)<<Count<<" trades per batch, last of "<<Batches<<" batches (ms)\n";
+    std::cout<<"Resource                  load     price      free  allocations  system\n";
+    RunTimes Times{};
+    double Check[3]{};
+
+    CountingResource Default{};
+    for(int Batch=0;Batch<Batches;++Batch)
+    {
+        Default.Counters={};
+        Times=LoadThenPrice(File,&Default,&Default);
+    };
+    Check[0]=Times.Value;
+    Report("new/delete",Times,Default.Counters,Default.Counters.Upstream);
+
+    //Monotonic arenas for both book and scratch: everything goes at once with Reset.
+    MonotonicArena BookArena{},RunArena{};
+    for(int Batch=0;Batch<Batches;++Batch)
+    {
+        BookArena.Counters=RunArena.Counters={};
+        Times=LoadThenPrice(File,&BookArena,&RunArena);
+        auto Start{std::chrono::steady_clock::now()};
+        BookArena.Reset();
+        RunArena.Reset();
+        Times.Free+=Seconds(Start);
+    };
+    Check[1]=Times.Value;
+    AllocationCounters Both{BookArena.Counters};
+    Both.Allocations+=RunArena.Counters.Allocations;
+    Report("monotonic arena",Times,Both,BookArena.Counters.Upstream+RunArena.Counters.Upstream);
+
+    //Size-class pool for the book (blocks are really freed and reused), arena for the scratch.
+    PoolResource Pool{};
+    for(int Batch=0;Batch<Batches;++Batch)
+    {
+        Pool.Counters=RunArena.Counters={};
+        Times=LoadThenPrice(File,&Pool,&RunArena);
+        RunArena.Reset();
+    };
+    Check[2]=Times.Value;
+    Both=Pool.Counters;
+    Both.Allocations+=RunArena.Counters.Allocations;
+    Report("size-class pool",Times,Both,Pool.Counters.Upstream+Pool.ArenaCounters().Upstream+RunArena.Counters.Upstream);
+    std::cout<<"Arena reserved "<<BookArena.Reserved()/1048576.0<<" MB for the book; book values agree : "
+        <<(Check[0]==Check[1]&&Check[1]==Check[2]?"yes":"no")<<"\n";
+    return 0;
+};
+/*
+Loads a million bond trades with heap-allocated identifiers, prices them with ZeroCouponBond into per-run
+scratch vectors and tears everything down, once through new/delete and once through each std::pmr resource
+in Arena.h, counting allocations and trips to the system allocator.
+
+Build with
+g++ -std=c++20 -O3 -march=native Arena.cc -o Arena
+*/
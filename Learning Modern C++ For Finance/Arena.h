@@ -0,0 +1,187 @@
+#ifndef Arena_H
+#define Arena_H
+#include<memory_resource>
+#include<vector>
+#include<array>
+#include<cstddef>
+#include<cstdint>
+#include<algorithm>
+
+struct AllocationCounters
+{
+    std::size_t Allocations{0};
+    std::size_t Deallocations{0};
+    std::size_t Bytes{0};
+    //Requests passed on to the upstream resource, i.e. real trips to the system allocator by default.
+    std::size_t Upstream{0};
+};
+//Forwards to another resource and counts; wrapped round new_delete_resource it measures the default path.
+class CountingResource:public std::pmr::memory_resource
+{
+public:
+    explicit CountingResource(std::pmr::memory_resource*Next=std::pmr::new_delete_resource()):Next{Next}{};
+    AllocationCounters Counters;
+private:
+    std::pmr::memory_resource*Next;
+    void*do_allocate(std::size_t Bytes,std::size_t Alignment)override
+    {
+        ++Counters.Allocations;
+        ++Counters.Upstream;
+        Counters.Bytes+=Bytes;
+        return Next->allocate(Bytes,Alignment);
+    };
+    void do_deallocate(void*p,std::size_t Bytes,std::size_t Alignment)override
+    {
+        ++Counters.Deallocations;
+        Next->deallocate(p,Bytes,Alignment);
+    };
+    bool do_is_equal(const std::pmr::memory_resource&Other)const noexcept override{return this==&Other;};
+};
+//Bump allocator over a list of chunks, each twice the size of the previous one. Deallocation is a no-op;
+//Reset rewinds to the first chunk and keeps every chunk, so a book or a pricing run that is rebuilt every
+//batch stops touching the upstream resource after the first batch. Not thread-safe: one arena per thread.
+class MonotonicArena:public std::pmr::memory_resource
+{
+public:
+    explicit MonotonicArena(std::size_t FirstChunk=1<<16,std::pmr::memory_resource*Upstream=std::pmr::new_delete_resource())
+        :FirstChunk{FirstChunk},UpstreamResource{Upstream}{};
+    MonotonicArena(const MonotonicArena&)=delete;
+    MonotonicArena&operator=(const MonotonicArena&)=delete;
+    ~MonotonicArena(){Release();};
+    void Reset()
+    {
+        Current=0;
+        Cursor=Chunks.empty()?nullptr:Chunks.front().Begin;
+        End=Chunks.empty()?nullptr:Chunks.front().Begin+Chunks.front().Size;
+    };
+    //Returns every chunk to the upstream resource.
+    void Release()
+    {
+        for(auto&Chunk:Chunks)UpstreamResource->deallocate(Chunk.Begin,Chunk.Size,alignof(std::max_align_t));
+        Chunks.clear();
+        Cursor=End=nullptr;
+        Current=0;
+    };
+    std::size_t Reserved()const
+    {
+        std::size_t Total{0};
+        for(auto&Chunk:Chunks)Total+=Chunk.Size;
+        return Total;
+    };
+    AllocationCounters Counters;
+private:
+    struct Chunk
+    {
+        std::byte*Begin;
+        std::size_t Size;
+    };
+    std::size_t FirstChunk;
+    std::pmr::memory_resource*UpstreamResource;
+    std::vector<Chunk>Chunks;
+    std::size_t Current{0};
+    std::byte*Cursor{nullptr};
+    std::byte*End{nullptr};
+    static std::byte*Align(std::byte*p,std::size_t Alignment)
+    {
+        auto Address{reinterpret_cast<std::uintptr_t>(p)};
+        return p+((Alignment-Address%Alignment)%Alignment);
+    };
+    void*do_allocate(std::size_t Bytes,std::size_t Alignment)override
+    {
+        ++Counters.Allocations;
+        Counters.Bytes+=Bytes;
+        std::byte*p{Cursor?Align(Cursor,Alignment):nullptr};
+        while(!p||p+Bytes>End)
+        {
+            //Move to the next kept chunk, or get a new one big enough for this request.
+            if(Cursor&&Current+1<Chunks.size())++Current;
+            else
+            {
+                std::size_t Size{std::max(Chunks.empty()?FirstChunk:2*Chunks.back().Size,Bytes+Alignment)};
+                ++Counters.Upstream;
+                Chunks.push_back({static_cast<std::byte*>(UpstreamResource->allocate(Size,alignof(std::max_align_t))),Size});
+                Current=Chunks.size()-1;
+            };
+            Cursor=Chunks[Current].Begin;
+            End=Cursor+Chunks[Current].Size;
+            p=Align(Cursor,Alignment);
+        };
+        Cursor=p+Bytes;
+        return p;
+    };
+    void do_deallocate(void*,std::size_t,std::size_t)override{++Counters.Deallocations;};
+    bool do_is_equal(const std::pmr::memory_resource&Other)const noexcept override{return this==&Other;};
+};
+//Size-class pool: requests up to MaxPooled bytes are rounded up to a power of two from 16 and served from a
+//per-class free list, refilled a slab at a time from an arena; freed blocks go back on their list. Larger
+//requests (the book's own array) go to the upstream resource, which really frees them. Suits trade objects
+//that are created and destroyed individually.
+class PoolResource:public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t MinPooled{16};
+    static constexpr std::size_t MaxPooled{1024};
+    static constexpr std::size_t Classes{7};
+    explicit PoolResource(std::pmr::memory_resource*Upstream=std::pmr::new_delete_resource()):UpstreamResource{Upstream},Slabs{1<<16,Upstream}{};
+    //Drops every block at once; the arena keeps its chunks for the next book.
+    void Reset()
+    {
+        FreeList.fill(nullptr);
+        Slabs.Reset();
+    };
+    AllocationCounters Counters;
+    const AllocationCounters&ArenaCounters()const{return Slabs.Counters;};
+private:
+    struct FreeBlock{FreeBlock*Next;};
+    std::pmr::memory_resource*UpstreamResource;
+    MonotonicArena Slabs;
+    std::array<FreeBlock*,Classes>FreeList{};
+    static std::size_t ClassOf(std::size_t Bytes)
+    {
+        std::size_t Class{0};
+        while((MinPooled<<Class)<Bytes)++Class;
+        return Class;
+    };
+    void*do_allocate(std::size_t Bytes,std::size_t Alignment)override
+    {
+        ++Counters.Allocations;
+        Counters.Bytes+=Bytes;
+        if(Bytes>MaxPooled||Alignment>MinPooled)
+        {
+            ++Counters.Upstream;
+            return UpstreamResource->allocate(Bytes,Alignment);
+        };
+        std::size_t Class{ClassOf(Bytes)};
+        if(!FreeList[Class])
+        {
+            std::size_t Size{MinPooled<<Class};
+            std::size_t Count{std::max<std::size_t>(8,4096/Size)};
+            auto*Slab{static_cast<std::byte*>(Slabs.allocate(Size*Count,MinPooled))};
+            for(std::size_t i=Count;i-->0;)
+            {
+                auto*Block{reinterpret_cast<FreeBlock*>(Slab+i*Size)};
+                Block->Next=FreeList[Class];
+                FreeList[Class]=Block;
+            };
+        };
+        FreeBlock*Block{FreeList[Class]};
+        FreeList[Class]=Block->Next;
+        return Block;
+    };
+    void do_deallocate(void*p,std::size_t Bytes,std::size_t Alignment)override
+    {
+        ++Counters.Deallocations;
+        if(Bytes>MaxPooled||Alignment>MinPooled)
+        {
+            UpstreamResource->deallocate(p,Bytes,Alignment);
+            return;
+        };
+        std::size_t Class{ClassOf(Bytes)};
+        auto*Block{static_cast<FreeBlock*>(p)};
+        Block->Next=FreeList[Class];
+        FreeList[Class]=Block;
+    };
+    bool do_is_equal(const std::pmr::memory_resource&Other)const noexcept override{return this==&Other;};
+};
+
+#endif
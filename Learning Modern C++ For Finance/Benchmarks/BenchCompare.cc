@@ -0,0 +1,83 @@
+#include<iostream>
+#include<fstream>
+#include<iomanip>
+#include<string>
+#include<vector>
+#include<map>
+#include<cstdlib>
+#include<cmath>
+//Reads the numeric field Key of one result line, NaN if absent.
+double Field(const std::string&Line,const std::string&Key)
+{
+    std::size_t At{Line.find("\""+Key+"\":")};
+    return At==std::string::npos?std::nan(""):std::strtod(Line.c_str()+At+Key.size()+3,nullptr);
+};
+std::string Name(const std::string&Line)
+{
+    std::size_t At{Line.find("\"name\":\"")};
+    if(At==std::string::npos)return {};
+    At+=8;
+    return Line.substr(At,Line.find('"',At)-At);
+};
+struct Entry
+{
+    double Median;
+    double Spread;
+};
+std::map<std::string,Entry>Load(const std::string&Path)
+{
+    std::map<std::string,Entry>Results{};
+    std::ifstream In{Path};
+    if(!In)
+    {
+        std::cerr<<"cannot read "<<Path<<"\n";
+        std::exit(2);
+    };
+    for(std::string Line;std::getline(In,Line);)
+    {
+        std::string Key{Name(Line)};
+        if(!Key.empty())Results[Key]={Field(Line,"median_ns_per_item"),Field(Line,"spread_ns_per_item")};
+    };
+    return Results;
+};
+int main(int argc,char**argv)
+{
+    if(argc<3)
+    {
+        std::cerr<<"usage: BenchCompare baseline.json candidate.json [threshold %, default 5]\n";
+        return 2;
+    };
+    double Threshold{argc>3?std::atof(argv[3]):5.0};
+    auto Baseline{Load(argv[1])};
+    auto Candidate{Load(argv[2])};
+    int Regressions{0};
+    std::cout<<std::setw(46)<<std::left<<"kernel"<<std::right<<std::setw(12)<<"base ns"<<std::setw(12)<<"new ns"<<std::setw(10)<<"change"<<"\n";
+    for(auto&[Key,New]:Candidate)
+    {
+        auto Found{Baseline.find(Key)};
+        std::cout<<std::setw(46)<<std::left<<Key<<std::right<<std::fixed<<std::setprecision(3);
+        if(Found==Baseline.end())
+        {
+            std::cout<<std::setw(12)<<"-"<<std::setw(12)<<New.Median<<std::setw(10)<<"new"<<"\n";
+            continue;
+        };
+        const Entry&Old{Found->second};
+        double Change{100.0*(New.Median/Old.Median-1.0)};
+        //A slowdown counts only if it clears the threshold and the combined noise of both runs.
+        bool Regressed{Change>Threshold&&New.Median-Old.Median>2.0*(Old.Spread+New.Spread)};
+        Regressions+=Regressed;
+        std::cout<<std::setw(12)<<Old.Median<<std::setw(12)<<New.Median<<std::setprecision(1)<<std::setw(9)<<Change<<"%"
+            <<(Regressed?"  REGRESSION":"")<<"\n";
+    };
+    for(auto&[Key,Old]:Baseline)if(!Candidate.count(Key))std::cout<<std::setw(46)<<std::left<<Key<<"  missing from candidate\n";
+    std::cout<<Regressions<<" regression(s) above "<<std::defaultfloat<<Threshold<<"%\n";
+    return Regressions?1:0;
+};
+/*
+Compares two benchmark result files written with --json and flags kernels whose median time per item
+grew by more than the threshold (and by more than twice the measured noise); exits 1 if any did, so a
+build script can fail on it.
+
+Build with
+make BenchCompare   (or g++ -std=c++20 -O2 BenchCompare.cc -o BenchCompare)
+*/
@@ -0,0 +1,210 @@
+#ifndef Benchmark_H
+#define Benchmark_H
+#include<vector>
+#include<string>
+#include<array>
+#include<chrono>
+#include<fstream>
+#include<iostream>
+#include<iomanip>
+#include<algorithm>
+#include<cstring>
+#include<cstdint>
+#include<cstdlib>
+#include<cmath>
+#include<sched.h>
+#include<unistd.h>
+#include<sys/ioctl.h>
+#include<sys/syscall.h>
+#include<linux/perf_event.h>
+
+//Keeps a result alive without a store the optimiser can see through.
+template<typename T>
+inline void DoNotOptimize(const T&Value)
+{
+    asm volatile(""::"g"(&Value):"memory");
+};
+//Pins the calling thread to one CPU so repetitions do not migrate between cores; false if not allowed.
+inline bool PinToCpu(int Cpu)
+{
+    cpu_set_t Set;
+    CPU_ZERO(&Set);
+    CPU_SET(Cpu,&Set);
+    return sched_setaffinity(0,sizeof Set,&Set)==0;
+};
+//User-space hardware counters for the calling thread, read as one group so they cover the same interval.
+//Where the PMU is not exposed (many VMs, perf_event_paranoid>2) Available is false and the counts are zero.
+class PerfCounters
+{
+public:
+    static constexpr std::size_t Count{4};
+    static constexpr std::array<const char*,Count>Names{"cycles","instructions","cache_misses","branch_misses"};
+    PerfCounters()
+    {
+        constexpr std::array<std::uint64_t,Count>Configs{PERF_COUNT_HW_CPU_CYCLES,PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES,PERF_COUNT_HW_BRANCH_MISSES};
+        for(std::size_t i=0;i<Count;++i)
+        {
+            perf_event_attr Attribute{};
+            Attribute.size=sizeof Attribute;
+            Attribute.type=PERF_TYPE_HARDWARE;
+            Attribute.config=Configs[i];
+            Attribute.disabled=i==0;
+            Attribute.exclude_kernel=1;
+            Attribute.exclude_hv=1;
+            Attribute.read_format=PERF_FORMAT_GROUP;
+            Fd[i]=static_cast<int>(syscall(SYS_perf_event_open,&Attribute,0,-1,i==0?-1:Fd[0],0));
+            if(Fd[i]<0)
+            {
+                Close();
+                return;
+            };
+        };
+        Available=true;
+    };
+    ~PerfCounters(){Close();};
+    PerfCounters(const PerfCounters&)=delete;
+    PerfCounters&operator=(const PerfCounters&)=delete;
+    void Start()
+    {
+        if(!Available)return;
+        ioctl(Fd[0],PERF_EVENT_IOC_RESET,PERF_IOC_FLAG_GROUP);
+        ioctl(Fd[0],PERF_EVENT_IOC_ENABLE,PERF_IOC_FLAG_GROUP);
+    };
+    std::array<double,Count>Stop()
+    {
+        std::array<double,Count>Values{};
+        if(!Available)return Values;
+        ioctl(Fd[0],PERF_EVENT_IOC_DISABLE,PERF_IOC_FLAG_GROUP);
+        std::uint64_t Buffer[1+Count]{};
+        if(read(Fd[0],Buffer,sizeof Buffer)==static_cast<ssize_t>(sizeof Buffer))
+        {
+            for(std::size_t i=0;i<Count;++i)Values[i]=static_cast<double>(Buffer[1+i]);
+        };
+        return Values;
+    };
+    bool Available{false};
+private:
+    std::array<int,Count>Fd{-1,-1,-1,-1};
+    void Close()
+    {
+        for(int&f:Fd)
+        {
+            if(f>=0)close(f);
+            f=-1;
+        };
+    };
+};
+struct BenchmarkOptions
+{
+    int Warmup{3};
+    int Repetitions{21};
+    int Cpu{0};
+    std::string Json{};
+};
+//Every repetition's wall time plus per-item hardware counts (medians over the repetitions).
+struct BenchmarkResult
+{
+    std::string Name;
+    std::size_t Items;
+    std::vector<double>Seconds;
+    std::array<double,PerfCounters::Count>PerItem{};
+    double Median()const
+    {
+        std::vector<double>Sorted{Seconds};
+        std::sort(Sorted.begin(),Sorted.end());
+        std::size_t n{Sorted.size()};
+        return n%2?Sorted[n/2]:0.5*(Sorted[n/2-1]+Sorted[n/2]);
+    };
+    double Minimum()const{return *std::min_element(Seconds.begin(),Seconds.end());};
+    //Median absolute deviation, scaled to estimate a standard deviation.
+    double Spread()const
+    {
+        double m{Median()};
+        std::vector<double>Deviation{};
+        for(double s:Seconds)Deviation.push_back(std::abs(s-m));
+        std::sort(Deviation.begin(),Deviation.end());
+        return 1.4826*Deviation[Deviation.size()/2];
+    };
+    double NanosecondsPerItem()const{return 1e9*Median()/Items;};
+};
+//Collects the kernels of one benchmark program. Options come from the command line:
+//--repetitions N, --warmup N, --cpu K (-1 to leave unpinned), --json FILE.
+class BenchmarkSuite
+{
+public:
+    BenchmarkSuite(const std::string&Name,int argc,char**argv):Suite{Name}
+    {
+        for(int i=1;i+1<argc;i+=2)
+        {
+            std::string Flag{argv[i]};
+            if(Flag=="--repetitions")Options.Repetitions=std::atoi(argv[i+1]);
+            else if(Flag=="--warmup")Options.Warmup=std::atoi(argv[i+1]);
+            else if(Flag=="--cpu")Options.Cpu=std::atoi(argv[i+1]);
+            else if(Flag=="--json")Options.Json=argv[i+1];
+        };
+        Pinned=Options.Cpu>=0&&PinToCpu(Options.Cpu);
+        std::cout<<Suite<<": "<<Options.Repetitions<<" repetitions after "<<Options.Warmup<<" warm-up runs, "
+            <<(Pinned?"pinned to CPU "+std::to_string(Options.Cpu):std::string{"not pinned"})<<", hardware counters "
+            <<(Counters.Available?"on":"unavailable")<<"\n";
+        std::cout<<std::setw(34)<<std::left<<"kernel"<<std::right<<std::setw(12)<<"ns/item"<<std::setw(10)<<"+-%"
+            <<std::setw(12)<<"min ns"<<std::setw(12)<<"cyc/item"<<std::setw(12)<<"ins/item"<<"\n";
+    };
+    ~BenchmarkSuite(){if(!Options.Json.empty())WriteJson(Options.Json);};
+    //Body() processes Items items and returns something that depends on all of them.
+    template<typename Function>
+    const BenchmarkResult&Run(const std::string&Name,std::size_t Items,Function&&Body)
+    {
+        for(int w=0;w<Options.Warmup;++w)DoNotOptimize(Body());
+        BenchmarkResult Result{Name,Items,{},{}};
+        std::vector<std::array<double,PerfCounters::Count>>Samples{};
+        for(int r=0;r<Options.Repetitions;++r)
+        {
+            Counters.Start();
+            auto Start{std::chrono::steady_clock::now()};
+            DoNotOptimize(Body());
+            double Elapsed{std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count()};
+            Samples.push_back(Counters.Stop());
+            Result.Seconds.push_back(Elapsed);
+        };
+        for(std::size_t c=0;c<PerfCounters::Count;++c)
+        {
+            std::vector<double>Column{};
+            for(auto&Sample:Samples)Column.push_back(Sample[c]);
+            std::nth_element(Column.begin(),Column.begin()+Column.size()/2,Column.end());
+            Result.PerItem[c]=Column[Column.size()/2]/Items;
+        };
+        Results.push_back(std::move(Result));
+        const BenchmarkResult&r{Results.back()};
+        std::cout<<std::setw(34)<<std::left<<Name<<std::right<<std::fixed<<std::setprecision(3)<<std::setw(12)<<r.NanosecondsPerItem()
+            <<std::setprecision(1)<<std::setw(10)<<100.0*r.Spread()/r.Median()<<std::setprecision(3)<<std::setw(12)<<1e9*r.Minimum()/Items
+            <<std::setprecision(2)<<std::setw(12)<<r.PerItem[0]<<std::setw(12)<<r.PerItem[1]<<"\n"<<std::defaultfloat;
+        return r;
+    };
+    //One object per line so BenchCompare (and grep) can read it without a JSON library.
+    void WriteJson(const std::string&Path)const
+    {
+        std::ofstream Out{Path};
+        Out<<"{\"suite\":\""<<Suite<<"\",\"compiler\":\""<<__VERSION__<<"\",\"pinned\":"<<(Pinned?"true":"false")
+            <<",\"counters\":"<<(Counters.Available?"true":"false")<<",\"results\":[\n";
+        Out<<std::setprecision(10);
+        for(std::size_t i=0;i<Results.size();++i)
+        {
+            const BenchmarkResult&r{Results[i]};
+            Out<<"{\"name\":\""<<Suite<<"/"<<r.Name<<"\",\"items\":"<<r.Items<<",\"repetitions\":"<<r.Seconds.size()
+                <<",\"median_ns_per_item\":"<<r.NanosecondsPerItem()<<",\"min_ns_per_item\":"<<1e9*r.Minimum()/r.Items
+                <<",\"spread_ns_per_item\":"<<1e9*r.Spread()/r.Items;
+            for(std::size_t c=0;c<PerfCounters::Count;++c)Out<<",\""<<PerfCounters::Names[c]<<"_per_item\":"<<r.PerItem[c];
+            Out<<"}"<<(i+1<Results.size()?",":"")<<"\n";
+        };
+        Out<<"]}\n";
+    };
+private:
+    std::string Suite;
+    BenchmarkOptions Options;
+    bool Pinned{false};
+    PerfCounters Counters;
+    std::vector<BenchmarkResult>Results;
+};
+
+#endif
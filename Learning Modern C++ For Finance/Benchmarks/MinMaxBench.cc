@@ -0,0 +1,67 @@
+#include"Benchmark.h"
+#include<random>
+#include<limits>
+//The three-argument maximum of minMax.cc, folded over an array.
+int GetMax(int&a,int&b,int&c)
+{
+    int MAX{a};
+    if(MAX<b)MAX=b;
+    if(MAX<c)MAX=c;
+    return MAX;
+};
+int main(int argc,char**argv)
+{
+    BenchmarkSuite Suite{"MinMax",argc,argv};
+    const std::size_t Count{1<<22};
+    std::mt19937 Generator{11};
+    std::uniform_int_distribution<int>Value{-1000000,1000000};
+    std::vector<int>Data(Count);
+    for(int&x:Data)x=Value(Generator);
+    Suite.Run("GetMax fold",Count,[&]
+    {
+        int Max{Data[0]};
+        std::size_t i{1};
+        for(;i+1<Count;i+=2)Max=GetMax(Max,Data[i],Data[i+1]);
+        //Even Count: one element left over.
+        if(i<Count)Max=GetMax(Max,Data[i],Data[i]);
+        return Max;
+    });
+    Suite.Run("std::minmax_element",Count,[&]
+    {
+        auto[Min,Max]{std::minmax_element(Data.begin(),Data.end())};
+        return static_cast<long>(*Max)-*Min;
+    });
+    Suite.Run("omp simd min/max reduction",Count,[&]
+    {
+        int Min{std::numeric_limits<int>::max()},Max{std::numeric_limits<int>::min()};
+        const int*__restrict x{Data.data()};
+        #pragma omp simd reduction(min:Min) reduction(max:Max)
+        for(std::size_t i=0;i<Count;++i)
+        {
+            Min=std::min(Min,x[i]);
+            Max=std::max(Max,x[i]);
+        };
+        return static_cast<long>(Max)-Min;
+    });
+    //GCC keeps the omp simd reductions in per-lane arrays; the plain loop vectorises into registers.
+    Suite.Run("auto-vectorised min/max",Count,[&]
+    {
+        int Min{std::numeric_limits<int>::max()},Max{std::numeric_limits<int>::min()};
+        const int*__restrict x{Data.data()};
+        for(std::size_t i=0;i<Count;++i)
+        {
+            Min=std::min(Min,x[i]);
+            Max=std::max(Max,x[i]);
+        };
+        return static_cast<long>(Max)-Min;
+    });
+    return 0;
+};
+/*
+Min/max over four million ints: the branchy GetMax of minMax.cc folded pairwise, std::minmax_element
+(which returns positions, so stays scalar) and a min/max reduction on the values, with and without
+the omp simd reduction clauses.
+
+Build with
+make MinMaxBench   (or g++ -std=c++20 -O3 -march=native -fopenmp-simd MinMaxBench.cc -o MinMaxBench)
+*/
@@ -0,0 +1,61 @@
+#include"Benchmark.h"
+#include"../BlackScholes.h"
+#include"../BinomialLattice.h"
+#include"../ImpliedVol.h"
+#include<random>
+int main(int argc,char**argv)
+{
+    BenchmarkSuite Suite{"Option",argc,argv};
+    const std::size_t Count{1<<18};
+    std::mt19937_64 Generator{3};
+    std::uniform_real_distribution<double>Strike{60.0,140.0},Years{0.1,3.0},Volatility{0.1,0.6};
+    std::vector<OptionStruct>Options(Count);
+    for(std::size_t i=0;i<Count;++i)Options[i]={100.0,Strike(Generator),0.03,Years(Generator),Volatility(Generator),i%2?1.0:-1.0,0.0};
+    Suite.Run("BlackScholes",Count,[&]
+    {
+        double Total{0.0};
+        for(auto&Option:Options)
+        {
+            BlackScholes(Option);
+            Total+=Option.Price;
+        };
+        return Total;
+    });
+    OptionQuoteColumns Quotes{};
+    Quotes.Resize(Count);
+    for(std::size_t i=0;i<Count;++i)
+    {
+        const OptionStruct&o{Options[i]};
+        Quotes.Price[i]=o.Price;
+        Quotes.Discount[i]=std::exp(-o.InterestRate*o.YearFraction);
+        Quotes.Forward[i]=o.Spot/Quotes.Discount[i];
+        Quotes.Strike[i]=o.Strike;
+        Quotes.YearFraction[i]=o.YearFraction;
+        Quotes.Theta[i]=o.Theta;
+    };
+    Suite.Run("ImpliedVolatilityBatch, 1 thread",Count,[&]
+    {
+        ImpliedVolatilityBatch(Quotes,1);
+        return Quotes.Volatility[Count/2];
+    });
+    const std::size_t Lattices{256};
+    Suite.Run("BinomialAmerican, 500 steps",Lattices,[&]
+    {
+        double Total{0.0};
+        for(std::size_t i=0;i<Lattices;++i)
+        {
+            OptionStruct Option{Options[i]};
+            BinomialAmerican(Option,500);
+            Total+=Option.Price;
+        };
+        return Total;
+    });
+    return 0;
+};
+/*
+Option kernels: closed-form Black-Scholes over a quarter of a million options, the batch implied-volatility
+solver on their prices, and the American binomial lattice at 500 steps.
+
+Build with
+make OptionBench   (or g++ -std=c++20 -O3 -march=native -fopenmp-simd -pthread OptionBench.cc -o OptionBench)
+*/
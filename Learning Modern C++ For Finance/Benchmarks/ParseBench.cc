@@ -0,0 +1,72 @@
+#include"Benchmark.h"
+#include"../ZeroCoupnBond.h"
+#include<sstream>
+#include<charconv>
+#include<random>
+//Parses "FaceValue InterestRate YearFraction" lines into bonds with a stream, the way Input() reads them.
+std::size_t ParseStream(const std::string&Text,std::vector<ZeroCouponStruct>&Bonds)
+{
+    Bonds.clear();
+    std::istringstream In{Text};
+    ZeroCouponStruct Zero{};
+    while(In>>Zero.FaceValue>>Zero.InterestRate>>Zero.YearFraction)Bonds.push_back(Zero);
+    return Bonds.size();
+};
+std::size_t ParseStrtod(const std::string&Text,std::vector<ZeroCouponStruct>&Bonds)
+{
+    Bonds.clear();
+    const char*p{Text.c_str()};
+    for(;;)
+    {
+        ZeroCouponStruct Zero{};
+        char*End;
+        Zero.FaceValue=std::strtod(p,&End);
+        if(End==p)break;
+        Zero.InterestRate=std::strtod(End,&End);
+        Zero.YearFraction=std::strtod(End,&End);
+        Bonds.push_back(Zero);
+        p=End;
+    };
+    return Bonds.size();
+};
+//No locale, no allocation, no stream state: one pass over the buffer.
+std::size_t ParseFromChars(const std::string&Text,std::vector<ZeroCouponStruct>&Bonds)
+{
+    Bonds.clear();
+    const char*p{Text.data()};
+    const char*End{p+Text.size()};
+    auto Field=[&](double&x)
+    {
+        while(p<End&&(*p==' '||*p=='\n'))++p;
+        auto[Next,Error]{std::from_chars(p,End,x)};
+        p=Next;
+        return Error==std::errc{};
+    };
+    ZeroCouponStruct Zero{};
+    while(Field(Zero.FaceValue)&&Field(Zero.InterestRate)&&Field(Zero.YearFraction))Bonds.push_back(Zero);
+    return Bonds.size();
+};
+int main(int argc,char**argv)
+{
+    BenchmarkSuite Suite{"Parse",argc,argv};
+    const std::size_t Count{1<<18};
+    std::mt19937_64 Generator{5};
+    std::uniform_real_distribution<double>Rate{0.0,0.08},Years{0.1,30.0};
+    std::ostringstream Out{};
+    Out<<std::setprecision(17);
+    for(std::size_t i=0;i<Count;++i)Out<<100.0<<" "<<Rate(Generator)<<" "<<Years(Generator)<<"\n";
+    const std::string Text{Out.str()};
+    std::vector<ZeroCouponStruct>Bonds{};
+    Bonds.reserve(Count);
+    Suite.Run("istringstream >>",Count,[&]{return ParseStream(Text,Bonds);});
+    Suite.Run("strtod",Count,[&]{return ParseStrtod(Text,Bonds);});
+    Suite.Run("std::from_chars",Count,[&]{return ParseFromChars(Text,Bonds);});
+    return 0;
+};
+/*
+I/O parsing: a quarter of a million bond lines (full-precision doubles) read from memory with a string
+stream, strtod and std::from_chars.
+
+Build with
+make ParseBench   (or g++ -std=c++20 -O3 -march=native ParseBench.cc -o ParseBench)
+*/
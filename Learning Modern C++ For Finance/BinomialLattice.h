@@ -0,0 +1,36 @@
+#ifndef BinomialLattice_H
+#define BinomialLattice_H
+#include<vector>
+#include<cmath>
+#include<algorithm>
+#include"BlackScholes.h"
+
+//Cox-Ross-Rubinstein lattice for an American option, rolled back in a single level buffer.
+inline void BinomialAmerican(OptionStruct&Option,int Steps)
+{
+    double dt{Option.YearFraction/Steps};
+    double Up{std::exp(Option.Volatility*std::sqrt(dt))};
+    double Down{1.0/Up};
+    double Discount{std::exp(-Option.InterestRate*dt)};
+    double pUp{(1.0/Discount-Down)/(Up-Down)};
+    double pUpDiscounted{Discount*pUp};
+    double pDownDiscounted{Discount*(1.0-pUp)};
+    std::vector<double>Level(Steps+1);
+    double Low{Option.Spot*std::pow(Down,Steps)};
+    double Ratio{Up*Up};
+    double Spot{Low};
+    for(int Node=0;Node<=Steps;++Node,Spot*=Ratio)Level[Node]=std::max(Option.Theta*(Spot-Option.Strike),0.0);
+    for(int Step=Steps-1;Step>=0;--Step)
+    {
+        Low*=Up;
+        Spot=Low;
+        for(int Node=0;Node<=Step;++Node,Spot*=Ratio)
+        {
+            double Continuation{pDownDiscounted*Level[Node]+pUpDiscounted*Level[Node+1]};
+            Level[Node]=std::max(Continuation,Option.Theta*(Spot-Option.Strike));
+        };
+    };
+    Option.Price=Level[0];
+};
+
+#endif
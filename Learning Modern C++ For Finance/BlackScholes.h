@@ -0,0 +1,50 @@
+#ifndef BlackScholes_H
+#define BlackScholes_H
+#include<iostream>
+#include<cmath>
+
+//Theta is +1 for a call and -1 for a put so the payoff max(Theta*(S-K),0) needs no branch.
+struct OptionStruct
+{
+    double Spot;
+    double Strike;
+    double InterestRate;
+    double YearFraction;
+    double Volatility;
+    double Theta;
+    double Price;
+    friend std::ostream& operator<<(std::ostream&out,const OptionStruct&);
+};
+inline std::ostream& operator<<(std::ostream&out,const OptionStruct&Option)
+{
+    out<<(Option.Theta>0?"Call":"Put")<<" Spot : "<<Option.Spot<<" Strike : "<<Option.Strike<<"\n";
+    out<<"Interest Rate : "<<Option.InterestRate<<" Year Fraction : "<<Option.YearFraction<<"\n";
+    out<<"Volatility : "<<Option.Volatility<<"\n";
+    out<<"=============\nPrice : "<<Option.Price<<"\n";
+    return out;
+};
+#pragma omp declare simd notinbranch
+inline double NormalPdf(double x)
+{
+    return 0.3989422804014327*std::exp(-0.5*x*x);
+};
+#pragma omp declare simd notinbranch
+inline double NormalCdf(double x)
+{
+    return 0.5*std::erfc(-x*0.7071067811865476);
+};
+//Black (1976) price on the forward, undiscounted.
+inline double BlackPrice(double Forward,double Strike,double TotalVolatility,double Theta)
+{
+    double d1{std::log(Forward/Strike)/TotalVolatility+0.5*TotalVolatility};
+    double d2{d1-TotalVolatility};
+    return Theta*(Forward*NormalCdf(Theta*d1)-Strike*NormalCdf(Theta*d2));
+};
+inline void BlackScholes(OptionStruct&Option)
+{
+    double Discount{std::exp(-Option.InterestRate*Option.YearFraction)};
+    double Forward{Option.Spot/Discount};
+    Option.Price=Discount*BlackPrice(Forward,Option.Strike,Option.Volatility*std::sqrt(Option.YearFraction),Option.Theta);
+};
+
+#endif
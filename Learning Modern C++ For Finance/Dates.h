@@ -0,0 +1,276 @@
+#ifndef Dates_H
+#define Dates_H
+#include<vector>
+#include<string>
+#include<cstdio>
+#include<cstdint>
+#include<cstddef>
+#include<bit>
+#include<algorithm>
+#include<utility>
+
+//A date is its serial day number, days since 1970-01-01 (negative before), so differences are subtractions
+//and a column of dates is a column of int32. Conversions use Hinnant's civil-calendar algorithms: integer
+//arithmetic only, valid for the whole proleptic Gregorian calendar, no tables and no branches worth the name.
+struct Date
+{
+    std::int32_t Serial{0};
+    friend bool operator==(Date,Date)=default;
+    friend auto operator<=>(Date,Date)=default;
+    friend std::int32_t operator-(Date a,Date b){return a.Serial-b.Serial;};
+    Date operator+(std::int32_t Days)const{return {Serial+Days};};
+    Date operator-(std::int32_t Days)const{return {Serial-Days};};
+};
+struct CivilDate
+{
+    std::int32_t Year;
+    std::int32_t Month;
+    std::int32_t Day;
+};
+inline std::int32_t SerialFromCivil(std::int32_t y,std::int32_t m,std::int32_t d)
+{
+    y-=m<=2;
+    std::int32_t Era{(y>=0?y:y-399)/400};
+    std::int32_t YearOfEra{y-Era*400};
+    std::int32_t DayOfYear{(153*(m+(m>2?-3:9))+2)/5+d-1};
+    std::int32_t DayOfEra{YearOfEra*365+YearOfEra/4-YearOfEra/100+DayOfYear};
+    return Era*146097+DayOfEra-719468;
+};
+inline CivilDate CivilFromSerial(std::int32_t Serial)
+{
+    std::int32_t z{Serial+719468};
+    std::int32_t Era{(z>=0?z:z-146096)/146097};
+    std::int32_t DayOfEra{z-Era*146097};
+    std::int32_t YearOfEra{(DayOfEra-DayOfEra/1460+DayOfEra/36524-DayOfEra/146096)/365};
+    std::int32_t DayOfYear{DayOfEra-(365*YearOfEra+YearOfEra/4-YearOfEra/100)};
+    std::int32_t MonthIndex{(5*DayOfYear+2)/153};
+    std::int32_t d{DayOfYear-(153*MonthIndex+2)/5+1};
+    std::int32_t m{MonthIndex<10?MonthIndex+3:MonthIndex-9};
+    return {YearOfEra+Era*400+(m<=2),m,d};
+};
+//CivilFromSerial as three plain values: a struct returned inside a simd loop is kept in memory and blocks it.
+inline void SplitSerial(std::int32_t Serial,std::int32_t&Year,std::int32_t&Month,std::int32_t&Day)
+{
+    std::int32_t z{Serial+719468};
+    std::int32_t Era{(z>=0?z:z-146096)/146097};
+    std::int32_t DayOfEra{z-Era*146097};
+    std::int32_t YearOfEra{(DayOfEra-DayOfEra/1460+DayOfEra/36524-DayOfEra/146096)/365};
+    std::int32_t DayOfYear{DayOfEra-(365*YearOfEra+YearOfEra/4-YearOfEra/100)};
+    std::int32_t MonthIndex{(5*DayOfYear+2)/153};
+    Day=DayOfYear-(153*MonthIndex+2)/5+1;
+    Month=MonthIndex<10?MonthIndex+3:MonthIndex-9;
+    Year=YearOfEra+Era*400+(Month<=2);
+};
+//Serial of 1 January of year y, for y>=1.
+inline std::int32_t YearStart(std::int32_t y)
+{
+    std::int32_t p{y-1};
+    return 365*p+p/4-p/100+p/400-719162;
+};
+inline Date MakeDate(std::int32_t Year,std::int32_t Month,std::int32_t Day){return {SerialFromCivil(Year,Month,Day)};};
+inline CivilDate Civil(Date d){return CivilFromSerial(d.Serial);};
+//0 Monday ... 6 Sunday; 1970-01-01 was a Thursday.
+inline std::int32_t Weekday(Date d)
+{
+    std::int32_t w{(d.Serial+3)%7};
+    return w<0?w+7:w;
+};
+//Without short-circuits, so it is a select inside vector loops.
+inline bool IsLeapYear(std::int32_t y){return ((y%4==0)&(y%100!=0))|(y%400==0);};
+inline std::string ToString(Date d)
+{
+    CivilDate c{Civil(d)};
+    char Text[40];
+    std::snprintf(Text,sizeof Text,"%04d-%02d-%02d",c.Year,c.Month,c.Day);
+    return Text;
+};
+
+//Thirty360 is the ISDA bond basis (30/360 US without the February rule).
+enum class DayCount:std::uint8_t{Act360,Act365Fixed,Thirty360,ActActIsda};
+//Year fractions for columns of start and end serials (End not before Start). One convention per call, so the
+//loop body has no switch; the civil conversions are inlined integer arithmetic and every loop vectorises.
+inline void YearFractions(const std::int32_t*Start,const std::int32_t*End,std::size_t Count,DayCount Basis,double*Out)
+{
+    const std::int32_t*__restrict s{Start};
+    const std::int32_t*__restrict e{End};
+    double*__restrict t{Out};
+    switch(Basis)
+    {
+    case DayCount::Act360:
+        #pragma omp simd
+        for(std::size_t i=0;i<Count;++i)t[i]=(e[i]-s[i])*(1.0/360.0);
+        return;
+    case DayCount::Act365Fixed:
+        #pragma omp simd
+        for(std::size_t i=0;i<Count;++i)t[i]=(e[i]-s[i])*(1.0/365.0);
+        return;
+    case DayCount::Thirty360:
+        #pragma omp simd
+        for(std::size_t i=0;i<Count;++i)
+        {
+            std::int32_t y1,m1,d1,y2,m2,d2;
+            SplitSerial(s[i],y1,m1,d1);
+            SplitSerial(e[i],y2,m2,d2);
+            d1=std::min(d1,30);
+            d2=d1==30?std::min(d2,30):d2;
+            t[i]=(360*(y2-y1)+30*(m2-m1)+d2-d1)*(1.0/360.0);
+        };
+        return;
+    case DayCount::ActActIsda:
+        #pragma omp simd
+        for(std::size_t i=0;i<Count;++i)
+        {
+            std::int32_t y1,m1,d1,y2,m2,d2;
+            SplitSerial(s[i],y1,m1,d1);
+            SplitSerial(e[i],y2,m2,d2);
+            //The same-year case folded in with 0/1 multipliers rather than a select: GCC turns selects back into
+            //branches around the int-to-double conversions, which may trap and so block if-conversion.
+            std::int32_t Apart{y1!=y2};
+            std::int32_t Head{Apart*(YearStart(y1+1)-e[i])+e[i]-s[i]};
+            std::int32_t Tail{Apart*(e[i]-YearStart(y2))};
+            std::int32_t Whole{Apart*(y2-y1-1)};
+            double Inverse1{IsLeapYear(y1)?1.0/366.0:1.0/365.0},Inverse2{IsLeapYear(y2)?1.0/366.0:1.0/365.0};
+            t[i]=Head*Inverse1+Whole+Tail*Inverse2;
+        };
+        return;
+    };
+};
+//One pair through the same loops, so a single date and a column give the same bits.
+inline double YearFraction(Date Start,Date End,DayCount Basis)
+{
+    double t;
+    YearFractions(&Start.Serial,&End.Serial,1,Basis,&t);
+    return t;
+};
+inline void YearFractions(const std::vector<std::int32_t>&Start,const std::vector<std::int32_t>&End,DayCount Basis,std::vector<double>&Out)
+{
+    Out.resize(End.size());
+    YearFractions(Start.data(),End.data(),End.size(),Basis,Out.data());
+};
+
+enum class Roll:std::uint8_t{Unadjusted,Following,ModifiedFollowing,Preceding};
+//Business days between First and Last (a fixed range of serials) as one bit per day, with a running count of
+//business days at the start of every 64-day word. Is a business day, next/previous business day and business
+//days between two dates are then a shift, a bit scan, and two popcounts; nothing walks the calendar.
+class HolidayCalendar
+{
+public:
+    std::string Name;
+    HolidayCalendar(std::string CalendarName,Date From,Date To):Name{std::move(CalendarName)},First{From},Days{To-From+1}
+    {
+        Bits.assign((Days+63)/64,0);
+        for(std::int32_t i=0;i<Days;++i)if(Weekday(First+i)<5)Bits[i/64]|=std::uint64_t{1}<<(i%64);
+        Count();
+    };
+    Date Begin()const{return First;};
+    Date End()const{return First+(Days-1);};
+    void AddHoliday(Date d)
+    {
+        std::int32_t i{d-First};
+        if(i<0||i>=Days)return;
+        Bits[i/64]&=~(std::uint64_t{1}<<(i%64));
+        Count();
+    };
+    void AddHolidays(const std::vector<Date>&Holidays)
+    {
+        for(Date d:Holidays)
+        {
+            std::int32_t i{d-First};
+            if(i>=0&&i<Days)Bits[i/64]&=~(std::uint64_t{1}<<(i%64));
+        };
+        Count();
+    };
+    //Dates outside the calendar's range count as business days on weekdays.
+    bool IsBusinessDay(Date d)const
+    {
+        std::int32_t i{d-First};
+        if(i<0||i>=Days)return Weekday(d)<5;
+        return Bits[i/64]>>(i%64)&1;
+    };
+    Date NextBusinessDay(Date d)const
+    {
+        std::int32_t i{d-First};
+        if(i<0||i>=Days)
+        {
+            while(Weekday(d)>=5)d=d+1;
+            return d;
+        };
+        std::size_t Word{static_cast<std::size_t>(i/64)};
+        std::uint64_t Ahead{Bits[Word]&(~std::uint64_t{0}<<(i%64))};
+        while(!Ahead&&++Word<Bits.size())Ahead=Bits[Word];
+        if(!Ahead)return NextBusinessDay(End()+1);
+        return First+static_cast<std::int32_t>(Word*64+std::countr_zero(Ahead));
+    };
+    Date PreviousBusinessDay(Date d)const
+    {
+        std::int32_t i{d-First};
+        if(i<0||i>=Days)
+        {
+            while(Weekday(d)>=5)d=d-1;
+            return d;
+        };
+        std::size_t Word{static_cast<std::size_t>(i/64)};
+        std::uint64_t Behind{Bits[Word]&(~std::uint64_t{0}>>(63-i%64))};
+        while(!Behind&&Word>0)Behind=Bits[--Word];
+        if(!Behind)return PreviousBusinessDay(First-1);
+        return First+static_cast<std::int32_t>(Word*64+63-std::countl_zero(Behind));
+    };
+    Date Adjust(Date d,Roll Convention)const
+    {
+        switch(Convention)
+        {
+        case Roll::Unadjusted:return d;
+        case Roll::Following:return NextBusinessDay(d);
+        case Roll::Preceding:return PreviousBusinessDay(d);
+        case Roll::ModifiedFollowing:
+        {
+            Date Next{NextBusinessDay(d)};
+            return Civil(Next).Month==Civil(d).Month?Next:PreviousBusinessDay(d);
+        }
+        };
+        return d;
+    };
+    //Business days in [From,To) for dates inside the calendar.
+    std::int32_t BusinessDaysBetween(Date From,Date To)const{return Rank(To)-Rank(From);};
+private:
+    Date First;
+    std::int32_t Days;
+    std::vector<std::uint64_t>Bits;
+    std::vector<std::int32_t>Before;
+    void Count()
+    {
+        Before.resize(Bits.size()+1);
+        Before[0]=0;
+        for(std::size_t w=0;w<Bits.size();++w)Before[w+1]=Before[w]+std::popcount(Bits[w]);
+    };
+    //Business days in [First,d).
+    std::int32_t Rank(Date d)const
+    {
+        std::int32_t i{std::clamp(d-First,0,Days)};
+        std::uint64_t Below{i%64?Bits[i/64]&((std::uint64_t{1}<<(i%64))-1):0};
+        return Before[i/64]+std::popcount(Below);
+    };
+};
+//Gregorian Easter Sunday (anonymous Gregorian algorithm).
+inline Date EasterSunday(std::int32_t y)
+{
+    std::int32_t a{y%19},b{y/100},c{y%100},d{b/4},e{b%4},f{(b+8)/25},g{(b-f+1)/3};
+    std::int32_t h{(19*a+b-d-g+15)%30},i{c/4},k{c%4},l{(32+2*e+2*i-h-k)%7},m{(a+11*h+22*l)/451};
+    std::int32_t Month{(h+l-7*m+114)/31},Day{(h+l-7*m+114)%31+1};
+    return MakeDate(y,Month,Day);
+};
+//TARGET2 (euro settlement): weekends, New Year, Good Friday, Easter Monday, 1 May, 25 and 26 December.
+inline HolidayCalendar TargetCalendar(std::int32_t FromYear,std::int32_t ToYear)
+{
+    HolidayCalendar Calendar{"TARGET",MakeDate(FromYear,1,1),MakeDate(ToYear,12,31)};
+    std::vector<Date>Holidays{};
+    for(std::int32_t y=FromYear;y<=ToYear;++y)
+    {
+        Date Easter{EasterSunday(y)};
+        for(Date d:{MakeDate(y,1,1),Easter-2,Easter+1,MakeDate(y,5,1),MakeDate(y,12,25),MakeDate(y,12,26)})Holidays.push_back(d);
+    };
+    Calendar.AddHolidays(Holidays);
+    return Calendar;
+};
+
+#endif
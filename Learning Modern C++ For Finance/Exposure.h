@@ -0,0 +1,182 @@
+#ifndef Exposure_H
+#define Exposure_H
+#include<vector>
+#include<cmath>
+#include<random>
+#include<cstdint>
+#include<cstddef>
+#include<algorithm>
+#include<stdexcept>
+#include"ZeroCoupnBond.h"
+#include"ShortRate.h"
+#include"Parallel.h"
+#include"Summation.h"
+#include"VectorMath.h"
+#include"Trace.h"
+
+//Trades as columns. A bond pays Notional at Maturity; an option (Expiry>0) is a European on that bond with
+//Strike and Theta (+1 call, -1 put), cash-settled at Expiry. Negative notionals are short positions.
+struct ExposureBook
+{
+    std::vector<std::uint32_t>NettingSet;
+    std::vector<double>Notional;
+    std::vector<double>Maturity;
+    std::vector<double>Expiry;
+    std::vector<double>Strike;
+    std::vector<double>Theta;
+    void AddBond(std::uint32_t Set,const ZeroCouponStruct&Bond)
+    {
+        AddOption(Set,Bond.FaceValue,Bond.YearFraction,0.0,0.0,1.0);
+    };
+    void AddOption(std::uint32_t Set,double Amount,double BondMaturity,double OptionExpiry,double OptionStrike,double CallPut)
+    {
+        NettingSet.push_back(Set);
+        Notional.push_back(Amount);
+        Maturity.push_back(BondMaturity);
+        Expiry.push_back(OptionExpiry);
+        Strike.push_back(OptionStrike);
+        Theta.push_back(CallPut);
+    };
+    std::size_t Size()const{return Notional.size();};
+};
+//Monte Carlo exposure under a Vasicek short rate. Paths are advanced one grid date at a time and the book is
+//repriced on them into one value per (netting set, path); those values are reduced to EE, discounted EE and
+//PFE before the next date. Memory is Sets x Paths plus a few path vectors, independent of the trade count
+//and the grid length; the path x trade x date cube is never formed.
+//Real is the type trades are repriced in; with float the per-path rates are narrowed and the exp/normal
+//kernels run at twice the width, while each trade's value is added into its netting set in double, and the
+//path state and the reductions over paths stay double.
+template<typename Real=double>
+struct ExposureEngine
+{
+    VasicekStruct Model;
+    std::size_t Paths;
+    std::size_t Sets;
+    std::vector<double>Grid{};
+    double Quantile{0.975};
+    double Recovery{0.4};
+    std::vector<double>Hazard{};
+    std::uint64_t Seed{42};
+    //Outputs, [Set*Grid.size()+Date].
+    std::vector<double>ExpectedExposure{};
+    std::vector<double>DiscountedExposure{};
+    std::vector<double>PotentialExposure{};
+    std::vector<double>Cva{};
+
+    std::vector<double>Rate{},Discount{},Scratch{};
+    std::vector<Real>PathRate{};
+    std::vector<double>Value{};
+    //Per-trade factors for the current date, shared by every path.
+    std::vector<double>ExpiryA{},ExpiryB{},MaturityA{},MaturityB{},OptionVolatility{},Moneyness{};
+
+    void Coefficients(const ExposureBook&Book,double t)
+    {
+        std::size_t n{Book.Size()};
+        for(auto*Column:{&ExpiryA,&ExpiryB,&MaturityA,&MaturityB,&OptionVolatility,&Moneyness})Column->resize(n);
+        for(std::size_t i=0;i<n;++i)
+        {
+            double Live{t<Book.Maturity[i]&&(Book.Expiry[i]==0.0||t<Book.Expiry[i])?1.0:0.0};
+            MaturityA[i]=Live*VasicekA(Model,Book.Maturity[i]-t);
+            MaturityB[i]=VasicekB(Model,Book.Maturity[i]-t);
+            if(Book.Expiry[i]>0.0&&Live>0.0)
+            {
+                ExpiryA[i]=VasicekA(Model,Book.Expiry[i]-t);
+                ExpiryB[i]=VasicekB(Model,Book.Expiry[i]-t);
+                OptionVolatility[i]=VasicekBondOptionVolatility(Model,t,Book.Expiry[i],Book.Maturity[i]);
+                Moneyness[i]=std::log(MaturityA[i]/(Book.Strike[i]*ExpiryA[i]));
+            }else ExpiryA[i]=ExpiryB[i]=OptionVolatility[i]=Moneyness[i]=0.0;
+        };
+    };
+    //Values every trade on paths [Begin,End) into Value; bonds are one exp per path, options a Black formula.
+    //ln(P(t,S)/(K P(t,T))) is affine in r, so the option needs no log per path.
+    void Reprice(const ExposureBook&Book,std::size_t Begin,std::size_t End)
+    {
+        for(std::size_t Set=0;Set<Sets;++Set)std::fill(Value.begin()+Set*Paths+Begin,Value.begin()+Set*Paths+End,0.0);
+        const Real*__restrict r{PathRate.data()};
+        for(std::size_t i=0;i<Book.Size();++i)
+        {
+            if(MaturityA[i]==0.0)continue;
+            double*__restrict v{Value.data()+Book.NettingSet[i]*Paths};
+            Real N{static_cast<Real>(Book.Notional[i])},AS{static_cast<Real>(MaturityA[i])},BS{static_cast<Real>(MaturityB[i])};
+            if(ExpiryA[i]==0.0)
+            {
+                #pragma omp simd
+                for(std::size_t p=Begin;p<End;++p)v[p]+=static_cast<double>(N*AS*ExpSimd(-BS*r[p]));
+                continue;
+            };
+            Real AT{static_cast<Real>(ExpiryA[i])},BT{static_cast<Real>(ExpiryB[i])},Vol{static_cast<Real>(OptionVolatility[i])};
+            Real K{static_cast<Real>(Book.Strike[i])},Theta{static_cast<Real>(Book.Theta[i])},m{static_cast<Real>(Moneyness[i])};
+            #pragma omp simd
+            for(std::size_t p=Begin;p<End;++p)
+            {
+                Real ZeroExpiry{AT*ExpSimd(-BT*r[p])};
+                Real ZeroMaturity{AS*ExpSimd(-BS*r[p])};
+                Real d1{(m-(BS-BT)*r[p])/Vol+Real(0.5)*Vol};
+                v[p]+=static_cast<double>(N*Theta*(ZeroMaturity*NormalCdfSimd(Theta*d1)-K*ZeroExpiry*NormalCdfSimd(Theta*(d1-Vol))));
+            };
+        };
+    };
+    //Throws std::invalid_argument without paths, without one hazard rate per netting set, or for a trade in a
+    //netting set at or above Sets.
+    void Run(const ExposureBook&Book,unsigned Threads=ThreadCount())
+    {
+        if(Paths==0)throw std::invalid_argument{"ExposureEngine: no paths"};
+        if(Hazard.size()!=Sets)throw std::invalid_argument{"ExposureEngine: Hazard needs one rate per netting set"};
+        for(std::uint32_t Set:Book.NettingSet)if(Set>=Sets)throw std::invalid_argument{"ExposureEngine: netting set not below Sets"};
+        std::size_t Dates{Grid.size()};
+        Rate.assign(Paths,Model.Rate);
+        Discount.assign(Paths,1.0);
+        Value.assign(Sets*Paths,0.0);
+        PathRate.resize(Paths);
+        Scratch.resize(Paths);
+        for(auto*Column:{&ExpectedExposure,&DiscountedExposure,&PotentialExposure})Column->assign(Sets*Dates,0.0);
+        std::mt19937_64 Engine{Seed};
+        std::normal_distribution<double>Normal{};
+        std::vector<double>Draws(Paths);
+        for(std::size_t Date=0;Date<Dates;++Date)
+        {
+            TRACE_SCOPE("Exposure date");
+            TRACE_COUNT("Trade-path pricings",Book.Size()*Paths);
+            double t{Grid[Date]};
+            if(Date>0)
+            {
+                double dt{t-Grid[Date-1]};
+                double Decay{std::exp(-Model.Kappa*dt)},Shock{VasicekStepVolatility(Model,dt)};
+                for(auto&z:Draws)z=Normal(Engine);
+                for(std::size_t p=0;p<Paths;++p)
+                {
+                    double Next{Rate[p]*Decay+Model.LongRunRate*(1.0-Decay)+Shock*Draws[p]};
+                    Discount[p]*=std::exp(-0.5*(Rate[p]+Next)*dt);
+                    Rate[p]=Next;
+                };
+            };
+            std::copy(Rate.begin(),Rate.end(),PathRate.begin());
+            Coefficients(Book,t);
+            ParallelFor(Paths,[&](std::size_t Begin,std::size_t End){Reprice(Book,Begin,End);},Threads);
+            for(std::size_t Set=0;Set<Sets;++Set)
+            {
+                const double*v{Value.data()+Set*Paths};
+                for(std::size_t p=0;p<Paths;++p)Scratch[p]=std::max(v[p],0.0);
+                double Sum{CompensatedSum(Paths,[&](std::size_t p){return Scratch[p];},1)};
+                double Discounted{CompensatedSum(Paths,[&](std::size_t p){return Scratch[p]*Discount[p];},1)};
+                std::size_t k{std::min(Paths-1,static_cast<std::size_t>(Quantile*Paths))};
+                std::nth_element(Scratch.begin(),Scratch.begin()+k,Scratch.end());
+                ExpectedExposure[Set*Dates+Date]=Sum/Paths;
+                DiscountedExposure[Set*Dates+Date]=Discounted/Paths;
+                PotentialExposure[Set*Dates+Date]=Scratch[k];
+            };
+        };
+        //Unilateral CVA with a flat hazard rate per netting set, discounted EE at the end of each period.
+        Cva.assign(Sets,0.0);
+        for(std::size_t Set=0;Set<Sets;++Set)
+        {
+            for(std::size_t Date=1;Date<Dates;++Date)
+            {
+                double Default{std::exp(-Hazard[Set]*Grid[Date-1])-std::exp(-Hazard[Set]*Grid[Date])};
+                Cva[Set]+=(1.0-Recovery)*DiscountedExposure[Set*Dates+Date]*Default;
+            };
+        };
+    };
+};
+
+#endif
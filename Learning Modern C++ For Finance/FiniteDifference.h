@@ -0,0 +1,259 @@
+#ifndef FiniteDifference_H
+#define FiniteDifference_H
+#include<vector>
+#include<cmath>
+#include<algorithm>
+#include<cstddef>
+#include"Trace.h"
+
+//A batch of American options sharing spot, rate, expiry and exercise side. Strike and Volatility may
+//differ per option. Theta is +1 for calls and -1 for puts.
+struct AmericanBatch
+{
+    double Spot;
+    double InterestRate;
+    double YearFraction;
+    double Theta;
+    std::vector<double>Strike;
+    std::vector<double>Volatility;
+    std::vector<double>Price;
+};
+//Tridiagonal system (I-Weight*dt*L) factored once per step size. In log-spot the operator has constant
+//coefficients, so Lower/Upper/Diagonal are one per lane; the factored diagonal varies by row.
+struct TridiagonalFactors
+{
+    std::vector<double>Lower;
+    std::vector<double>Upper;
+    std::vector<double>Diagonal;
+    std::vector<double>InverseDiagonal;
+    std::vector<double>Factor;
+};
+//Options per block. A compile-time width turns every lane loop into straight-line vector ops, and two
+//AVX-512 vectors (four AVX2) per row give the recurrences some independent work to overlap.
+constexpr std::size_t FiniteDifferenceLanes{16};
+//One block of lanes is solved at a time on a shared grid. Rows are interleaved across the block,
+//element [Row*Lanes+Lane], so each sweep is a contiguous vector op over the lanes, and the whole block
+//(about 5*(SpaceSteps+1)*Lanes doubles) stays in L2 for the entire time march.
+//Buffers are only resized when the grid grows, so repeated pricing and every time step run without allocating.
+struct FiniteDifferenceWorkspace
+{
+    int SpaceSteps;
+    int TimeSteps;
+    int SmoothingSteps{2};
+    std::vector<double>Value;
+    std::vector<double>Rhs;
+    std::vector<double>Payoff;
+    std::vector<double>GeneratorLower;
+    std::vector<double>GeneratorDiagonal;
+    std::vector<double>GeneratorUpper;
+    std::vector<double>BoundaryLow;
+    std::vector<double>BoundaryHigh;
+    TridiagonalFactors CrankNicolson;
+    TridiagonalFactors Implicit;
+};
+//Generator of the Black-Scholes PDE in x=ln(S) on a uniform grid:
+//L V_i = (a-b) V_{i-1} - (2a+r) V_i + (a+b) V_{i+1}.
+inline void LogSpotCoefficients(double Volatility,double InterestRate,double dx,double&a,double&b)
+{
+    a=0.5*Volatility*Volatility/(dx*dx);
+    b=0.5*(InterestRate-0.5*Volatility*Volatility)/dx;
+};
+//Factors I-Weight*dt*L. Puts are eliminated from the top and substituted upwards, calls the other way
+//round, so that the early-exercise projection during substitution is the Brennan-Schwartz solution.
+inline void FactorTridiagonal(TridiagonalFactors&Factors,const FiniteDifferenceWorkspace&Work,bool Put,double Weight,double dt)
+{
+    constexpr std::size_t Lanes{FiniteDifferenceLanes};
+    int N{Work.SpaceSteps};
+    for(auto*Column:{&Factors.Lower,&Factors.Upper,&Factors.Diagonal})Column->resize(Lanes);
+    Factors.InverseDiagonal.resize((N+1)*Lanes);
+    Factors.Factor.resize((N+1)*Lanes);
+    for(std::size_t m=0;m<Lanes;++m)
+    {
+        Factors.Lower[m]=-Weight*dt*Work.GeneratorLower[m];
+        Factors.Upper[m]=-Weight*dt*Work.GeneratorUpper[m];
+        Factors.Diagonal[m]=1.0-Weight*dt*Work.GeneratorDiagonal[m];
+    };
+    //Puts: Factor_i=u/dd_{i+1}, dd_i=d-Factor_i*l. Calls: Factor_i=l/dd_{i-1}, dd_i=d-Factor_i*u.
+    const double*Across{Put?Factors.Lower.data():Factors.Upper.data()};
+    const double*Along{Put?Factors.Upper.data():Factors.Lower.data()};
+    int First{Put?N-1:1};
+    int Direction{Put?-1:1};
+    for(std::size_t m=0;m<Lanes;++m)
+    {
+        Factors.InverseDiagonal[First*Lanes+m]=1.0/Factors.Diagonal[m];
+        Factors.Factor[First*Lanes+m]=0.0;
+    };
+    for(int i=First+Direction;i>=1&&i<N;i+=Direction)
+    {
+        std::size_t k{i*Lanes};
+        std::size_t Previous{(i-Direction)*Lanes};
+        for(std::size_t m=0;m<Lanes;++m)
+        {
+            double f{Along[m]*Factors.InverseDiagonal[Previous+m]};
+            Factors.Factor[k+m]=f;
+            Factors.InverseDiagonal[k+m]=1.0/(Factors.Diagonal[m]-f*Across[m]);
+        };
+    };
+};
+//Right-hand side V+w*L V of one row from the old values, eliminated against the previous row.
+inline void EliminateRow(double*__restrict Rhs,const double*__restrict PreviousRhs,const double*__restrict Value,
+    const double*__restrict Factor,const FiniteDifferenceWorkspace&Work,const double*__restrict Edge,double w)
+{
+    const double*__restrict Lower{Work.GeneratorLower.data()};
+    const double*__restrict Diagonal{Work.GeneratorDiagonal.data()};
+    const double*__restrict Upper{Work.GeneratorUpper.data()};
+    constexpr std::size_t Lanes{FiniteDifferenceLanes};
+    #pragma omp simd
+    for(std::size_t m=0;m<Lanes;++m)
+    {
+        double Explicit{Lower[m]*Value[m-Lanes]+Diagonal[m]*Value[m]+Upper[m]*Value[m+Lanes]};
+        Rhs[m]=Value[m]+w*Explicit-Edge[m]-Factor[m]*PreviousRhs[m];
+    };
+};
+//Back substitution of one row with the projection onto the payoff.
+inline void SubstituteRow(double*__restrict Value,const double*__restrict Neighbour,const double*__restrict Rhs,
+    const double*__restrict Across,const double*__restrict Inverse,const double*__restrict Payoff)
+{
+    #pragma omp simd
+    for(std::size_t m=0;m<FiniteDifferenceLanes;++m)
+    {
+        double Solved{(Rhs[m]-Across[m]*Neighbour[m])*Inverse[m]};
+        Value[m]=Solved>Payoff[m]?Solved:Payoff[m];
+    };
+};
+//One time step. The first sweep, in elimination order, builds the right-hand side
+//V+ExplicitWeight*dt*L V from the old values and eliminates it in the same pass; the second sweep
+//substitutes back and projects onto the payoff (Brennan-Schwartz). ExplicitWeight is 0.5 for
+//Crank-Nicolson and 0 for the implicit start-up steps.
+inline void TimeStep(const TridiagonalFactors&Factors,FiniteDifferenceWorkspace&Work,bool Put,double ExplicitWeight,double dt)
+{
+    constexpr std::size_t Lanes{FiniteDifferenceLanes};
+    int N{Work.SpaceSteps};
+    double*Rhs{Work.Rhs.data()};
+    double*Value{Work.Value.data()};
+    const double*Payoff{Work.Payoff.data()};
+    const double*Inverse{Factors.InverseDiagonal.data()};
+    const double*Factor{Factors.Factor.data()};
+    double w{ExplicitWeight*dt};
+    //The known boundary values enter the first and last interior rows; Factor is zero on the row where
+    //elimination starts, and Rhs rows 0 and N are kept at zero so that row can read them harmlessly.
+    double Low[Lanes],High[Lanes],None[Lanes]{};
+    for(std::size_t m=0;m<Lanes;++m)
+    {
+        Low[m]=Factors.Lower[m]*Work.BoundaryLow[m];
+        High[m]=Factors.Upper[m]*Work.BoundaryHigh[m];
+    };
+    auto Edge=[&](int i){return i==1?Low:(i==N-1?High:None);};
+    if(Put)
+    {
+        for(int i=N-1;i>=1;--i)EliminateRow(Rhs+i*Lanes,Rhs+(i+1)*Lanes,Value+i*Lanes,Factor+i*Lanes,Work,Edge(i),w);
+    }else
+    {
+        for(int i=1;i<N;++i)EliminateRow(Rhs+i*Lanes,Rhs+(i-1)*Lanes,Value+i*Lanes,Factor+i*Lanes,Work,Edge(i),w);
+    };
+    std::copy(Work.BoundaryLow.begin(),Work.BoundaryLow.end(),Value);
+    std::copy(Work.BoundaryHigh.begin(),Work.BoundaryHigh.end(),Value+N*Lanes);
+    if(Put)
+    {
+        for(int i=1;i<N;++i)SubstituteRow(Value+i*Lanes,Value+(i-1)*Lanes,Rhs+i*Lanes,Factors.Lower.data(),Inverse+i*Lanes,Payoff+i*Lanes);
+    }else
+    {
+        for(int i=N-1;i>=1;--i)SubstituteRow(Value+i*Lanes,Value+(i+1)*Lanes,Rhs+i*Lanes,Factors.Upper.data(),Inverse+i*Lanes,Payoff+i*Lanes);
+    };
+};
+//Prices options [Begin,Begin+Count) of the batch on their own log-spot grid. A short last block is padded
+//by repeating its last option. Spot sits on the middle node and the grid reaches five standard deviations
+//beyond the furthest strike.
+inline void CrankNicolsonBlock(AmericanBatch&Batch,std::size_t Begin,std::size_t Count,FiniteDifferenceWorkspace&Work)
+{
+    constexpr std::size_t Lanes{FiniteDifferenceLanes};
+    double Strike[Lanes],Volatility[Lanes];
+    for(std::size_t m=0;m<Lanes;++m)
+    {
+        Strike[m]=Batch.Strike[Begin+std::min(m,Count-1)];
+        Volatility[m]=Batch.Volatility[Begin+std::min(m,Count-1)];
+    };
+    int N{Work.SpaceSteps};
+    bool Put{Batch.Theta<0.0};
+    double r{Batch.InterestRate};
+    double LogSpot{std::log(Batch.Spot)};
+    double Width{0.0};
+    for(std::size_t m=0;m<Lanes;++m)
+    {
+        Width=std::max(Width,std::abs(std::log(Strike[m])-LogSpot)+5.0*Volatility[m]*std::sqrt(Batch.YearFraction));
+    };
+    double dx{2.0*Width/N};
+    double xMin{LogSpot-0.5*N*dx};
+    double dt{Batch.YearFraction/Work.TimeSteps};
+    std::size_t Size{(N+1)*Lanes};
+    Work.Value.resize(Size);
+    Work.Payoff.resize(Size);
+    Work.Rhs.assign(Size,0.0);
+    for(auto*Column:{&Work.GeneratorLower,&Work.GeneratorDiagonal,&Work.GeneratorUpper,&Work.BoundaryLow,&Work.BoundaryHigh})Column->resize(Lanes);
+
+    for(std::size_t m=0;m<Lanes;++m)
+    {
+        double a,b;
+        LogSpotCoefficients(Volatility[m],r,dx,a,b);
+        Work.GeneratorLower[m]=a-b;
+        Work.GeneratorDiagonal[m]=-(2.0*a+r);
+        Work.GeneratorUpper[m]=a+b;
+    };
+    for(int i=0;i<=N;++i)
+    {
+        double Spot{std::exp(xMin+i*dx)};
+        for(std::size_t m=0;m<Lanes;++m)
+        {
+            std::size_t k{i*Lanes+m};
+            Work.Payoff[k]=std::max(Batch.Theta*(Spot-Strike[m]),0.0);
+            Work.Value[k]=Work.Payoff[k];
+        };
+    };
+    FactorTridiagonal(Work.CrankNicolson,Work,Put,0.5,dt);
+    FactorTridiagonal(Work.Implicit,Work,Put,1.0,0.5*dt);
+
+    double SpotLow{std::exp(xMin)},SpotHigh{std::exp(xMin+N*dx)};
+    auto Boundaries=[&](double Tau)
+    {
+        for(std::size_t m=0;m<Lanes;++m)
+        {
+            double DiscountedStrike{Strike[m]*std::exp(-r*Tau)};
+            Work.BoundaryLow[m]=std::max(Batch.Theta*(SpotLow-DiscountedStrike),Work.Payoff[m]);
+            Work.BoundaryHigh[m]=std::max(Batch.Theta*(SpotHigh-DiscountedStrike),Work.Payoff[N*Lanes+m]);
+        };
+    };
+    double Tau{0.0};
+    for(int Step=0;Step<Work.TimeSteps;++Step)
+    {
+        if(Step<Work.SmoothingSteps)
+        {
+            for(int Half=0;Half<2;++Half)
+            {
+                Tau+=0.5*dt;
+                Boundaries(Tau);
+                TimeStep(Work.Implicit,Work,Put,0.0,0.5*dt);
+            };
+            continue;
+        };
+        Tau+=dt;
+        Boundaries(Tau);
+        TimeStep(Work.CrankNicolson,Work,Put,0.5,dt);
+    };
+    for(std::size_t m=0;m<Count;++m)Batch.Price[Begin+m]=Work.Value[(N/2)*Lanes+m];
+};
+//Crank-Nicolson with Rannacher start-up (the first SmoothingSteps steps are each replaced by two implicit
+//half steps to damp the payoff kink), block by block through one workspace.
+inline void CrankNicolsonAmerican(AmericanBatch&Batch,FiniteDifferenceWorkspace&Work)
+{
+    Work.SpaceSteps+=Work.SpaceSteps&1;
+    std::size_t Options{Batch.Strike.size()};
+    Batch.Price.resize(Options);
+    TRACE_COUNT("American options",Options);
+    for(std::size_t Begin=0;Begin<Options;Begin+=FiniteDifferenceLanes)
+    {
+        TRACE_SCOPE("Crank-Nicolson block");
+        CrankNicolsonBlock(Batch,Begin,std::min(FiniteDifferenceLanes,Options-Begin),Work);
+    };
+};
+
+#endif
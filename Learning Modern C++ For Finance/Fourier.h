@@ -0,0 +1,206 @@
+#ifndef Fourier_H
+#define Fourier_H
+#include<vector>
+#include<complex>
+#include<cmath>
+#include<map>
+#include<cstddef>
+#include<algorithm>
+#include<stdexcept>
+#include"Trace.h"
+
+using Complex=std::complex<double>;
+
+//Heston stochastic volatility: dv=Kappa(LongRunVariance-v)dt+VolOfVol sqrt(v)dW, corr(dW,dS)=Rho.
+struct HestonStruct
+{
+    double Spot;
+    double InterestRate;
+    double Variance;
+    double Kappa;
+    double LongRunVariance;
+    double VolOfVol;
+    double Rho;
+};
+//Variance gamma: Brownian motion with drift Drift and volatility Sigma run on a gamma clock of variance rate Nu.
+struct VarianceGammaStruct
+{
+    double Spot;
+    double InterestRate;
+    double Sigma;
+    double Nu;
+    double Drift;
+};
+//E[exp(iu ln S_T)] under the risk-neutral measure.
+//Uses the rotation-free form of Albrecher et al. ("little Heston trap") so the log never crosses its branch cut.
+inline Complex CharacteristicFunction(const HestonStruct&Model,Complex u,double YearFraction)
+{
+    const Complex i{0.0,1.0};
+    double Sigma2{Model.VolOfVol*Model.VolOfVol};
+    Complex Beta{Model.Kappa-Model.Rho*Model.VolOfVol*i*u};
+    Complex d{std::sqrt(Beta*Beta+Sigma2*(i*u+u*u))};
+    Complex g{(Beta-d)/(Beta+d)};
+    Complex Decay{std::exp(-d*YearFraction)};
+    Complex C{Model.Kappa*Model.LongRunVariance/Sigma2*((Beta-d)*YearFraction-2.0*std::log((1.0-g*Decay)/(1.0-g)))};
+    Complex D{(Beta-d)/Sigma2*(1.0-Decay)/(1.0-g*Decay)};
+    return std::exp(i*u*(std::log(Model.Spot)+Model.InterestRate*YearFraction)+C+D*Model.Variance);
+};
+inline Complex CharacteristicFunction(const VarianceGammaStruct&Model,Complex u,double YearFraction)
+{
+    const Complex i{0.0,1.0};
+    double Omega{std::log(1.0-Model.Drift*Model.Nu-0.5*Model.Sigma*Model.Sigma*Model.Nu)/Model.Nu};
+    Complex Base{1.0-i*u*Model.Drift*Model.Nu+0.5*Model.Sigma*Model.Sigma*Model.Nu*u*u};
+    return std::exp(i*u*(std::log(Model.Spot)+(Model.InterestRate+Omega)*YearFraction)-YearFraction/Model.Nu*std::log(Base));
+};
+//In-place iterative radix-2 transform, X_k=sum_j x_j exp(-2 pi i jk/N). Twiddles and the bit-reversal
+//permutation are computed once per size, which must be a power of two.
+struct FastFourierTransform
+{
+    std::size_t Size;
+    std::vector<Complex>Twiddle;
+    std::vector<std::size_t>Reversed;
+    explicit FastFourierTransform(std::size_t N):Size{N},Twiddle(N/2),Reversed(N)
+    {
+        if(N==0||(N&(N-1))!=0)throw std::invalid_argument{"FastFourierTransform: size must be a power of two"};
+        int Bits{0};
+        while((std::size_t{1}<<Bits)<N)++Bits;
+        for(std::size_t k=0;k<N/2;++k)Twiddle[k]=std::polar(1.0,-2.0*M_PI*k/N);
+        for(std::size_t k=0;k<N;++k)
+        {
+            std::size_t r{0};
+            for(int b=0;b<Bits;++b)r|=((k>>b)&1)<<(Bits-1-b);
+            Reversed[k]=r;
+        };
+    };
+    void operator()(std::vector<Complex>&x)const
+    {
+        for(std::size_t k=0;k<Size;++k)if(k<Reversed[k])std::swap(x[k],x[Reversed[k]]);
+        for(std::size_t Half=1;Half<Size;Half*=2)
+        {
+            std::size_t Stride{Size/(2*Half)};
+            for(std::size_t Start=0;Start<Size;Start+=2*Half)
+            {
+                for(std::size_t k=0;k<Half;++k)
+                {
+                    Complex t{Twiddle[k*Stride]*x[Start+k+Half]};
+                    x[Start+k+Half]=x[Start+k]-t;
+                    x[Start+k]+=t;
+                };
+            };
+        };
+    };
+};
+//Carr-Madan: the damped call exp(alpha k)C(k) has Fourier transform
+//Psi(v)=exp(-rT)phi(v-(alpha+1)i)/(alpha^2+alpha-v^2+i(2alpha+1)v), so one FFT of Psi on v_j=j*Eta gives calls
+//on the whole log-strike grid k_u=ln(Spot)-N*Lambda/2+u*Lambda, Lambda=2pi/(N*Eta).
+//The Simpson-weighted Psi values are cached per expiry, so a strip only costs one FFT plus interpolation. The
+//cache depends on the model and grid, so those are only changed through SetModel and SetGrid, which empty it;
+//it holds at most CacheLimit expiries and is emptied when full. Points must be a power of two, at least 4
+//for the interpolation stencil.
+template<typename Model>
+struct CarrMadanEngine
+{
+    static constexpr std::size_t CacheLimit{256};
+    std::size_t CharacteristicEvaluations{0};
+    explicit CarrMadanEngine(const Model&Dynamics,std::size_t Points=4096,double Eta=0.25,double Alpha=1.5)
+        :Dynamics{Dynamics},Points{CheckedPoints(Points)},Eta{Eta},Alpha{Alpha},Transform{Points}{};
+    const Model&Parameters()const{return Dynamics;};
+    //After a recalibration.
+    void SetModel(const Model&Calibrated)
+    {
+        Dynamics=Calibrated;
+        Cache.clear();
+    };
+    void SetGrid(std::size_t NewPoints,double NewEta,double NewAlpha)
+    {
+        CheckedPoints(NewPoints);
+        if(NewPoints!=Points)Transform=FastFourierTransform{NewPoints};
+        Points=NewPoints;
+        Eta=NewEta;
+        Alpha=NewAlpha;
+        Cache.clear();
+    };
+    double Lambda()const{return 2.0*M_PI/(Points*Eta);};
+    double LowestLogStrike()const{return std::log(Dynamics.Spot)-0.5*Points*Lambda();};
+    //Damped transform of the call price at frequency v, before quadrature weights.
+    Complex Psi(double v,double YearFraction)
+    {
+        const Complex i{0.0,1.0};
+        ++CharacteristicEvaluations;
+        Complex Phi{CharacteristicFunction(Dynamics,Complex{v,-(Alpha+1.0)},YearFraction)};
+        return std::exp(-Dynamics.InterestRate*YearFraction)*Phi/(Alpha*Alpha+Alpha-v*v+i*(2.0*Alpha+1.0)*v);
+    };
+    const std::vector<Complex>&Weights(double YearFraction)
+    {
+        auto Found{Cache.find(YearFraction)};
+        if(Found!=Cache.end())return Found->second;
+        if(Cache.size()>=CacheLimit)Cache.clear();
+        std::vector<Complex>Column(Points);
+        const Complex i{0.0,1.0};
+        double Shift{-LowestLogStrike()};
+        for(std::size_t j=0;j<Points;++j)
+        {
+            double v{j*Eta};
+            double Simpson{(j==0?1.0:(j&1?4.0:2.0))/3.0};
+            Column[j]=std::exp(i*Shift*v)*Psi(v,YearFraction)*Eta*Simpson;
+        };
+        return Cache.emplace(YearFraction,std::move(Column)).first->second;
+    };
+    //Calls for every strike in Strikes, by four-point Lagrange interpolation on the FFT log-strike grid.
+    void PriceStrip(double YearFraction,const std::vector<double>&Strikes,std::vector<double>&Prices)
+    {
+        TRACE_SCOPE("Carr-Madan strip");
+        TRACE_COUNT("Fourier strikes",Strikes.size());
+        Scratch=Weights(YearFraction);
+        Transform(Scratch);
+        double Step{Lambda()};
+        double Low{LowestLogStrike()};
+        Prices.resize(Strikes.size());
+        for(std::size_t s=0;s<Strikes.size();++s)
+        {
+            double k{std::log(Strikes[s])};
+            double Position{(k-Low)/Step};
+            std::size_t Base{static_cast<std::size_t>(std::clamp(std::floor(Position)-1.0,0.0,static_cast<double>(Points-4)))};
+            double t{Position-Base};
+            double Value{0.0};
+            for(std::size_t a=0;a<4;++a)
+            {
+                double Weight{1.0};
+                for(std::size_t b=0;b<4;++b)if(a!=b)Weight*=(t-b)/(static_cast<double>(a)-b);
+                double Node{Low+(Base+a)*Step};
+                Value+=Weight*std::exp(-Alpha*Node)/M_PI*Scratch[Base+a].real();
+            };
+            Prices[s]=Value;
+        };
+    };
+    //One strike on its own: the same Simpson quadrature summed directly, with fresh characteristic
+    //function values, i.e. what pricing a strip strike by strike costs.
+    double PriceSingle(double YearFraction,double Strike)
+    {
+        const Complex i{0.0,1.0};
+        double k{std::log(Strike)};
+        double Sum{0.0};
+        for(std::size_t j=0;j<Points;++j)
+        {
+            double v{j*Eta};
+            double Simpson{(j==0?1.0:(j&1?4.0:2.0))/3.0};
+            Sum+=(std::exp(-i*v*k)*Psi(v,YearFraction)).real()*Eta*Simpson;
+        };
+        return std::exp(-Alpha*k)/M_PI*Sum;
+    };
+private:
+    static std::size_t CheckedPoints(std::size_t N)
+    {
+        if(N<4||(N&(N-1))!=0)throw std::invalid_argument{"CarrMadanEngine: Points must be a power of two, at least 4"};
+        return N;
+    };
+    Model Dynamics;
+    std::size_t Points;
+    double Eta;
+    double Alpha;
+    FastFourierTransform Transform;
+    std::map<double,std::vector<Complex>>Cache{};
+    std::vector<Complex>Scratch{};
+};
+
+#endif
@@ -0,0 +1,137 @@
+#ifndef HistoricalVaR_H
+#define HistoricalVaR_H
+#include<vector>
+#include<cmath>
+#include<cstdint>
+#include<cstddef>
+#include<algorithm>
+#include<type_traits>
+#include<stdexcept>
+#include"ZeroCoupnBond.h"
+#include"Parallel.h"
+#include"Summation.h"
+#include"VectorMath.h"
+#include"Trace.h"
+
+//Historical zero-rate moves at the curve pillars, pillar-major: Shift[Pillar*Count+Scenario], so for one
+//pillar the scenarios are contiguous and a bond can be revalued under a whole tile of them with unit stride.
+struct ScenarioMatrix
+{
+    std::vector<double>Pillars;
+    std::size_t Count{0};
+    std::vector<double>Shift;
+    void Resize(std::size_t Scenarios)
+    {
+        Count=Scenarios;
+        Shift.assign(Pillars.size()*Count,0.0);
+    };
+    double&operator()(std::size_t Pillar,std::size_t Scenario){return Shift[Pillar*Count+Scenario];};
+};
+//Column layout of a book of ZeroCouponStructs. Each bond keeps its base price and where its maturity falls
+//between the pillars, so a scenario shift is two loads and a lerp.
+struct ZeroCouponBook
+{
+    std::vector<double>Price;
+    std::vector<double>YearFraction;
+    std::vector<std::uint32_t>Left;
+    std::vector<double>Weight;
+    //Prices copies of the bonds; the caller's structs are left as they are. Pillars must be increasing, at
+    //least two of them, as each bond reads the pillar on either side; throws std::invalid_argument otherwise.
+    void Load(const std::vector<ZeroCouponStruct>&Bonds,const std::vector<double>&Pillars)
+    {
+        if(Pillars.size()<2)throw std::invalid_argument{"ZeroCouponBook: at least two pillars are needed"};
+        std::size_t n{Bonds.size()};
+        Price.resize(n);
+        YearFraction.resize(n);
+        Left.resize(n);
+        Weight.resize(n);
+        for(std::size_t b=0;b<n;++b)
+        {
+            ZeroCouponStruct Priced{Bonds[b]};
+            ZeroCouponBond(Priced);
+            double t{Priced.YearFraction};
+            Price[b]=Priced.Price;
+            YearFraction[b]=t;
+            //Flat beyond the first and last pillars.
+            std::size_t Right{static_cast<std::size_t>(std::upper_bound(Pillars.begin(),Pillars.end(),t)-Pillars.begin())};
+            Right=std::clamp<std::size_t>(Right,1,Pillars.size()-1);
+            Left[b]=static_cast<std::uint32_t>(Right-1);
+            Weight[b]=std::clamp((t-Pillars[Right-1])/(Pillars[Right]-Pillars[Right-1]),0.0,1.0);
+        };
+    };
+    std::size_t Size()const{return Price.size();};
+    //Base value of the book, the same bits for any thread count.
+    double PresentValue(unsigned Threads=ThreadCount())const{return CompensatedSum(Price,Threads);};
+};
+//Full-revaluation historical VaR. Scenarios are cut into tiles of ScenarioTile; a tile's PnL accumulators and
+//the pillar shifts it reads stay in L1 while the whole book streams past once, so every bond is loaded once
+//per tile instead of once per scenario. Threads take disjoint ranges of tiles; a scenario's PnL is always
+//summed over the book in book order, so it does not depend on the thread count.
+//Real is the type the bonds are revalued in. HistoricalVaREngine<float> narrows the book and the scenarios
+//once per Revalue and prices in float, twice the lanes and half the bytes streamed; the PnL accumulators
+//stay double.
+template<typename Real=double>
+struct HistoricalVaREngine
+{
+    std::size_t ScenarioTile{128};
+    std::vector<double>PnL;
+    void RevalueTiles(const ZeroCouponBook&Book,const ScenarioMatrix&Scenarios,std::size_t Begin,std::size_t End)
+    {
+        const Real*Prices{Narrowed(Book.Price,NarrowPrice)};
+        const Real*Years{Narrowed(Book.YearFraction,NarrowYearFraction)};
+        const Real*Weights{Narrowed(Book.Weight,NarrowWeight)};
+        const Real*Shifts{Narrowed(Scenarios.Shift,NarrowShift)};
+        std::vector<double>Accumulator(ScenarioTile);
+        for(std::size_t Tile=Begin;Tile<End;Tile+=ScenarioTile)
+        {
+            TRACE_SCOPE("VaR scenario tile");
+            std::size_t Width{std::min(End,Tile+ScenarioTile)-Tile};
+            double*__restrict Sum{Accumulator.data()};
+            std::fill(Sum,Sum+Width,0.0);
+            for(std::size_t b=0;b<Book.Size();++b)
+            {
+                Real Price{Prices[b]},t{Years[b]},w{Weights[b]};
+                const Real*__restrict Low{Shifts+Book.Left[b]*Scenarios.Count+Tile};
+                const Real*__restrict High{Low+Scenarios.Count};
+                #pragma omp simd
+                for(std::size_t s=0;s<Width;++s)Sum[s]+=Price*(ExpSimd(-t*(Low[s]+w*(High[s]-Low[s])))-Real(1));
+            };
+            std::copy(Sum,Sum+Width,PnL.begin()+Tile);
+        };
+    };
+    void Revalue(const ZeroCouponBook&Book,const ScenarioMatrix&Scenarios,unsigned Threads=ThreadCount())
+    {
+        TRACE_SCOPE("VaR revaluation");
+        TRACE_COUNT("Bond-scenario pricings",Book.Size()*Scenarios.Count);
+        if constexpr(!std::is_same_v<Real,double>)
+        {
+            Narrow(Book.Price,NarrowPrice);
+            Narrow(Book.YearFraction,NarrowYearFraction);
+            Narrow(Book.Weight,NarrowWeight);
+            Narrow(Scenarios.Shift,NarrowShift);
+        };
+        PnL.assign(Scenarios.Count,0.0);
+        ParallelFor(Scenarios.Count,[&](std::size_t Begin,std::size_t End){RevalueTiles(Book,Scenarios,Begin,End);},Threads,ScenarioTile);
+    };
+    //Loss not exceeded with probability Confidence, read off the PnL with nth_element in O(n). Throws
+    //std::logic_error if there is no PnL, i.e. before a Revalue with at least one scenario.
+    double ValueAtRisk(double Confidence)const
+    {
+        if(PnL.empty())throw std::logic_error{"HistoricalVaREngine: no scenario PnL to take VaR from"};
+        std::vector<double>Sorted{PnL};
+        std::size_t k{static_cast<std::size_t>(std::floor((1.0-Confidence)*Sorted.size()))};
+        k=std::min(k,Sorted.size()-1);
+        std::nth_element(Sorted.begin(),Sorted.begin()+k,Sorted.end());
+        return -Sorted[k];
+    };
+private:
+    std::vector<Real>NarrowPrice,NarrowYearFraction,NarrowWeight,NarrowShift;
+    static void Narrow(const std::vector<double>&From,std::vector<Real>&To){To.assign(From.begin(),From.end());};
+    static const Real*Narrowed(const std::vector<double>&From,const std::vector<Real>&To)
+    {
+        if constexpr(std::is_same_v<Real,double>)return From.data();
+        else return To.data();
+    };
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include"ImpliedVol.h"
+#include<chrono>
+#include<random>
+#include<cstdlib>
+int main(int argc,char**argv)
+{
+    std::size_t Count{argc>1?std::strtoull(argv[1],nullptr,10):1000000};
+    OptionQuoteColumns Quotes{};
+    Quotes.Resize(Count);
+    std::vector<double>TrueVolatility(Count);
+    std::mt19937_64 Engine{42};
+    std::uniform_real_distribution<double>Moneyness{-1.0,1.0};
+    std::uniform_real_distribution<double>Expiry{0.05,5.0};
+    std::uniform_real_distribution<double>Vol{0.05,1.0};
+    for(std::size_t i=0;i<Count;++i)
+    {
+        Quotes.Forward[i]=100.0;
+        Quotes.YearFraction[i]=Expiry(Engine);
+        Quotes.Strike[i]=100.0*std::exp(Moneyness(Engine)*std::sqrt(Quotes.YearFraction[i]));
+        Quotes.Discount[i]=std::exp(-0.03*Quotes.YearFraction[i]);
+        Quotes.Theta[i]=(i&1)?1.0:-1.0;
+        TrueVolatility[i]=Vol(Engine);
+        Quotes.Price[i]=Quotes.Discount[i]*BlackPrice(Quotes.Forward[i],Quotes.Strike[i],TrueVolatility[i]*std::sqrt(Quotes.YearFraction[i]),Quotes.Theta[i]);
+    };
+
+    auto Start{std::chrono::steady_clock::now()};
+    ImpliedVolatilityBatch(Quotes,1);
+    double Single{std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count()};
+    Start=std::chrono::steady_clock::now();
+    ImpliedVolatilityBatch(Quotes);
+    double Multi{std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count()};
+
+    //Out-of-the-money quotes must round-trip to 1e-12. In-the-money quotes carry the intrinsic value, and
+    //the rounding of that alone moves sigma by about eps*Price/Vega, so that is added to their tolerance.
+    //Quotes whose time value is below round-off carry no volatility information and are skipped.
+    double MaxError{0.0};
+    std::size_t Checked{0},Failed{0};
+    for(std::size_t i=0;i<Count;++i)
+    {
+        double Intrinsic{std::max(Quotes.Theta[i]*(Quotes.Forward[i]-Quotes.Strike[i]),0.0)};
+        double TimeValue{Quotes.Price[i]/Quotes.Discount[i]-Intrinsic};
+        if(TimeValue<1e-6*Quotes.Forward[i])continue;
+        double RootT{std::sqrt(Quotes.YearFraction[i])};
+        double d1{std::log(Quotes.Forward[i]/Quotes.Strike[i])/(TrueVolatility[i]*RootT)+0.5*TrueVolatility[i]*RootT};
+        double Vega{Quotes.Discount[i]*Quotes.Forward[i]*NormalPdf(d1)*RootT};
+        double Tolerance{1e-12+(Intrinsic>0.0?8.0*std::numeric_limits<double>::epsilon()*Quotes.Price[i]/Vega:0.0)};
+        double Error{std::abs(Quotes.Volatility[i]-TrueVolatility[i])};
+        ++Checked;
+        if(!(Error<=Tolerance))++Failed;
+        MaxError=std::max(MaxError,std::isnan(Error)?1.0:Error);
+    };
+    std::cout<<"Quotes : "<<Count<<"  Threads : "<<ThreadCount()<<"\n";
+    std::cout<<"Checked : "<<Checked<<"  Max |sigma error| : "<<MaxError<<"  Out of tolerance : "<<Failed<<"\n";
+    std::cout<<"Single thread : "<<Count/Single/1e6<<" M quotes/s\n";
+    std::cout<<"All threads   : "<<Count/Multi/1e6<<" M quotes/s\n";
+    return Failed==0?0:1;
+};
+/*
+Inverts Black-Scholes prices back to volatilities in bulk and round-trips them against the
+volatilities that generated the prices.
+
+Build with
+g++ -std=c++20 -O3 -march=native -fopenmp-simd -fno-math-errno -pthread ImpliedVol.cc -o ImpliedVol
+*/
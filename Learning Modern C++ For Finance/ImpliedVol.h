@@ -0,0 +1,126 @@
+#ifndef ImpliedVol_H
+#define ImpliedVol_H
+#include<vector>
+#include<cmath>
+#include<limits>
+#include<algorithm>
+#include<cstddef>
+#include"BlackScholes.h"
+#include"Parallel.h"
+#include"Trace.h"
+
+//Column layout for a batch of quotes; one index is one quote.
+struct OptionQuoteColumns
+{
+    std::vector<double>Price;
+    std::vector<double>Forward;
+    std::vector<double>Strike;
+    std::vector<double>YearFraction;
+    std::vector<double>Discount;
+    std::vector<double>Theta;
+    std::vector<double>Volatility;
+    void Resize(std::size_t Count)
+    {
+        for(auto*Column:{&Price,&Forward,&Strike,&YearFraction,&Discount,&Theta,&Volatility})Column->resize(Count);
+    };
+    std::size_t Size()const{return Price.size();};
+};
+//Acklam's rational approximation, polished with one Halley step against erfc.
+//Both the central and the tail rational are evaluated and one is selected, so there is no branch.
+#pragma omp declare simd notinbranch
+inline double InverseNormalCdf(double p)
+{
+    double q{p-0.5};
+    double r{q*q};
+    double Central{(((((-3.969683028665376e+01*r+2.209460984245205e+02)*r-2.759285104469687e+02)*r+1.383577518672690e+02)*r-3.066479806614716e+01)*r+2.506628277459239e+00)*q
+        /(((((-5.447609879822406e+01*r+1.615858368580409e+02)*r-1.556989798598866e+02)*r+6.680131188771972e+01)*r-1.328068155288572e+01)*r+1.0)};
+    double t{std::sqrt(-2.0*std::log(std::min(p,1.0-p)))};
+    double Tail{(((((-7.784894002430293e-03*t-3.223964580411365e-01)*t-2.400758277161838e+00)*t-2.549732539343734e+00)*t+4.374664141464968e+00)*t+2.938163982698783e+00)
+        /((((7.784695709041462e-03*t+3.224671290700398e-01)*t+2.445134137142996e+00)*t+3.754408661907416e+00)*t+1.0)};
+    Tail=q>0.0?-Tail:Tail;
+    double x{std::abs(q)<=0.47575?Central:Tail};
+    double e{NormalCdf(x)-p};
+    double u{e*2.5066282746310002*std::exp(0.5*x*x)};
+    return x-u/(1.0+0.5*x*u);
+};
+//Normalised Black call b(x,s)=e^{x/2}N(x/s+s/2)-e^{-x/2}N(x/s-s/2) with x=ln(F/K), s=sigma*sqrt(T).
+#pragma omp declare simd notinbranch
+inline double NormalisedBlack(double x,double s)
+{
+    double Ratio{x/s};
+    return std::exp(0.5*x)*NormalCdf(Ratio+0.5*s)-std::exp(-0.5*x)*NormalCdf(Ratio-0.5*s);
+};
+constexpr int ImpliedVolIterations{4};
+//Implied Black volatility of one quote.
+//The quote is reduced to an out-of-the-money call in normalised units, the starting point is Jaeckel's
+//two-branch guess either side of the inflection point s=sqrt(2|x|), and it is refined by a fixed number
+//of third-order Householder steps. The lower guess is only asymptotically right, so below the inflection
+//point the larger of the two guesses is used; each step is also kept within a factor of four of the last.
+//Below the inflection point the objective is ln(b)-ln(beta), which is much closer to linear for low prices. Every branch is a select so the body vectorises.
+//Prices outside the no-arbitrage bounds return NaN.
+#pragma omp declare simd notinbranch
+inline double ImpliedVolatility(double Price,double Forward,double Strike,double YearFraction,double Discount,double Theta)
+{
+    double x{std::log(Forward/Strike)};
+    double Beta{Price/(Discount*std::sqrt(Forward*Strike))};
+    double Half{std::exp(0.5*x)};
+    Beta-=std::max(Theta*(Half-1.0/Half),0.0);
+    x=-std::abs(x);
+    double Ceiling{std::exp(0.5*x)};
+    bool Valid{Beta>0.0&&Beta<Ceiling};
+    Beta=Valid?Beta:0.5*Ceiling;
+
+    double sc{std::max(std::sqrt(-2.0*x),1e-10)};
+    double bc{NormalisedBlack(x,sc)};
+    bool Low{Beta<bc};
+    double sLow{std::sqrt(2.0*x*x/std::max(-x-4.0*std::log(Beta/bc),1e-300))};
+    double sHigh{-2.0*InverseNormalCdf((Ceiling-Beta)/(Ceiling-bc)*NormalCdf(-0.5*sc))};
+    double s{Low?std::max(sLow,sHigh):sHigh};
+    double LogBeta{std::log(Beta)};
+    double xx{x*x};
+    for(int Iteration=0;Iteration<ImpliedVolIterations;++Iteration)
+    {
+        double b{NormalisedBlack(x,s)};
+        double Vega{0.3989422804014327*std::exp(-0.5*(xx/(s*s)+0.25*s*s))};
+        double h2{xx/(s*s*s)-0.25*s};
+        double h3{h2*h2-3.0*xx/(s*s*s*s)-0.25};
+        double r{Vega/b};
+        double f{Low?std::log(b)-LogBeta:b-Beta};
+        double Slope{Low?r:Vega};
+        double H2{Low?h2-r:h2};
+        double H3{Low?h3-3.0*h2*r+2.0*r*r:h3};
+        double Nu{-f/Slope};
+        double Step{Nu*(1.0+0.5*H2*Nu)/(1.0+H2*Nu+H3*Nu*Nu/6.0)};
+        s=std::min(std::max(s+Step,0.25*s),4.0*s);
+    };
+    return Valid?s/std::sqrt(YearFraction):std::numeric_limits<double>::quiet_NaN();
+};
+//Fills Quotes.Volatility over [Begin,End). With -fopenmp-simd and -fno-math-errno GCC maps the
+//exp/log/erfc calls to libmvec and runs one quote per SIMD lane.
+inline void ImpliedVolatility(OptionQuoteColumns&Quotes,std::size_t Begin,std::size_t End)
+{
+    const double*Price{Quotes.Price.data()};
+    const double*Forward{Quotes.Forward.data()};
+    const double*Strike{Quotes.Strike.data()};
+    const double*YearFraction{Quotes.YearFraction.data()};
+    const double*Discount{Quotes.Discount.data()};
+    const double*Theta{Quotes.Theta.data()};
+    double*Volatility{Quotes.Volatility.data()};
+    #pragma omp simd
+    for(std::size_t i=Begin;i<End;++i)
+    {
+        Volatility[i]=ImpliedVolatility(Price[i],Forward[i],Strike[i],YearFraction[i],Discount[i],Theta[i]);
+    };
+};
+//Whole batch, split across threads by contiguous strike/expiry ranges.
+inline void ImpliedVolatilityBatch(OptionQuoteColumns&Quotes,unsigned Threads=ThreadCount())
+{
+    TRACE_COUNT("Implied volatility quotes",Quotes.Size());
+    ParallelFor(Quotes.Size(),[&](std::size_t Begin,std::size_t End)
+    {
+        TRACE_SCOPE("Implied volatility chunk");
+        ImpliedVolatility(Quotes,Begin,End);
+    },Threads);
+};
+
+#endif
@@ -0,0 +1,386 @@
+#ifndef Journal_H
+#define Journal_H
+#include<atomic>
+#include<thread>
+#include<chrono>
+#include<memory>
+#include<string>
+#include<vector>
+#include<filesystem>
+#include<system_error>
+#include<cerrno>
+#include<cstring>
+#include<cstdint>
+#include<cstddef>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<fcntl.h>
+#include<unistd.h>
+#include"ZeroCoupnBond.h"
+#include"VectorMath.h"
+#include"Queue.h"
+
+//One journal entry, fixed size so entry i sits at byte 48*i and carries Sequence i+1. Trade adds (Trade equal
+//to the book size) or amends a bond, Remove closes one, Spread moves the parallel spread over every bond's
+//rate. Check covers the other fields, so a torn or never-written tail fails it and ends the replay.
+enum class JournalKind:std::uint32_t{Trade=1,Remove=2,Spread=3};
+struct JournalRecord
+{
+    std::uint64_t Sequence;
+    JournalKind Kind;
+    std::uint32_t Check;
+    std::uint64_t Trade;
+    double FaceValue;
+    double InterestRate;
+    double YearFraction;
+};
+static_assert(sizeof(JournalRecord)==48);
+inline std::uint32_t JournalCheck(const JournalRecord&Record)
+{
+    std::uint64_t Words[6];
+    std::memcpy(Words,&Record,sizeof Words);
+    //Words[1] holds Kind and Check; only Kind is covered.
+    Words[1]&=0xFFFFFFFFull;
+    std::uint64_t h{0x9E3779B97F4A7C15ull};
+    for(std::uint64_t w:Words)
+    {
+        h=(h^w)*0xBF58476D1CE4E5B9ull;
+        h^=h>>29;
+    };
+    return static_cast<std::uint32_t>(h^(h>>32));
+};
+inline bool JournalValid(const JournalRecord&Record,std::uint64_t Sequence)
+{
+    return Record.Sequence==Sequence&&Record.Check==JournalCheck(Record);
+};
+
+//Zero-coupon book as columns; a trade's id is its row. Removed trades keep their row with a zero face value.
+//Prices are kept current: Apply reprices the row it changes, or the whole book when the spread moves.
+struct PricedBook
+{
+    std::vector<double>FaceValue{};
+    std::vector<double>InterestRate{};
+    std::vector<double>YearFraction{};
+    std::vector<double>Price{};
+    double Spread{0.0};
+    //Last journal sequence reflected in the columns.
+    std::uint64_t Sequence{0};
+    std::size_t Size()const{return Price.size();};
+    void Load(const std::vector<ZeroCouponStruct>&Bonds)
+    {
+        const std::size_t n{Bonds.size()};
+        for(auto*Column:{&FaceValue,&InterestRate,&YearFraction,&Price})Column->resize(n);
+        for(std::size_t i=0;i<n;++i)
+        {
+            FaceValue[i]=Bonds[i].FaceValue;
+            InterestRate[i]=Bonds[i].InterestRate;
+            YearFraction[i]=Bonds[i].YearFraction;
+        };
+        Reprice();
+    };
+    void Reprice()
+    {
+        const std::size_t n{Size()};
+        const double s{Spread};
+        const double*Face{FaceValue.data()},*Rate{InterestRate.data()},*Years{YearFraction.data()};
+        double*Out{Price.data()};
+        #pragma omp simd
+        for(std::size_t i=0;i<n;++i)Out[i]=Face[i]*ExpSimd(-(Rate[i]+s)*Years[i]);
+    };
+    //Applies one record; with Deferred set a spread move only records the spread and leaves the caller to
+    //Reprice once, which is what replay does.
+    void Apply(const JournalRecord&Record,bool Deferred=false)
+    {
+        Sequence=Record.Sequence;
+        std::size_t Row{static_cast<std::size_t>(Record.Trade)};
+        switch(Record.Kind)
+        {
+        case JournalKind::Trade:
+            if(Row==Size())for(auto*Column:{&FaceValue,&InterestRate,&YearFraction,&Price})Column->push_back(0.0);
+            FaceValue[Row]=Record.FaceValue;
+            InterestRate[Row]=Record.InterestRate;
+            YearFraction[Row]=Record.YearFraction;
+            //ExpSimd as in Reprice, so a replayed book matches the live one bit for bit.
+            Price[Row]=FaceValue[Row]*ExpSimd(-(InterestRate[Row]+Spread)*YearFraction[Row]);
+            break;
+        case JournalKind::Remove:
+            FaceValue[Row]=0.0;
+            Price[Row]=0.0;
+            break;
+        case JournalKind::Spread:
+            Spread=Record.InterestRate;
+            if(!Deferred)Reprice();
+            break;
+        };
+    };
+    ZeroCouponStruct Bond(std::size_t Row)const{return {FaceValue[Row],InterestRate[Row],YearFraction[Row],Price[Row]};};
+};
+
+//Append-only journal in a memory-mapped file with group commit. Append only stamps the check and pushes the
+//record on an SPSC ring; a writer thread pops whatever has accumulated, copies it into the mapping, msyncs
+//that range once for the whole group and then advances Durable. While one group is being synced the next
+//one accumulates, so the flush cost is shared by every record that arrived meanwhile and the appending
+//thread never waits on the disk. Opening an existing file continues after its last valid record, and never
+//before After, the sequence of the snapshot the book was restored from: if the journal lost records the
+//snapshot already holds, new records must not reuse their sequences, which recovery would skip.
+//The constructor throws std::system_error if the file cannot be opened or mapped. If the writer fails to grow,
+//map or msync the file, Durable stops where it is and Append and WaitDurable throw the error from then on.
+class BookJournal
+{
+public:
+    //Microseconds the writer sleeps when the ring is empty; the upper bound on an idle group's latency.
+    long IdleMicroseconds{50};
+    explicit BookJournal(const std::string&Path,std::uint64_t After=0):Ring{std::make_unique<SpscRing<JournalRecord,1<<16>>()}
+    {
+        Fd=open(Path.c_str(),O_RDWR|O_CREAT|O_CLOEXEC,0644);
+        if(Fd<0)throw std::system_error{errno,std::generic_category(),"open "+Path};
+        struct stat Status{};
+        if(fstat(Fd,&Status)<0)Fail("fstat "+Path,errno);
+        if(int Error{Map(std::max({static_cast<std::size_t>(Status.st_size)/sizeof(JournalRecord),std::size_t{1}<<16,static_cast<std::size_t>(After)}))})
+            Fail("map "+Path,Error);
+        while(Next<Capacity&&JournalValid(Records[Next],Next+1))++Next;
+        Next=std::max<std::size_t>(Next,After);
+        Durable.store(Next,std::memory_order_relaxed);
+        Appended=Next;
+        Writer=std::thread{[this]{Write();}};
+    };
+    ~BookJournal()
+    {
+        Stop.store(true,std::memory_order_release);
+        Writer.join();
+        munmap(Records,Capacity*sizeof(JournalRecord));
+        close(Fd);
+    };
+    BookJournal(const BookJournal&)=delete;
+    BookJournal&operator=(const BookJournal&)=delete;
+    //Sequence the next record must carry.
+    std::uint64_t NextSequence()const{return Appended+1;};
+    //Record.Sequence must be NextSequence().
+    void Append(JournalRecord Record)
+    {
+        ThrowIfFailed();
+        Record.Check=JournalCheck(Record);
+        Ring->Push(Record);
+        ++Appended;
+    };
+    //Highest sequence known to be on disk.
+    std::uint64_t DurableSequence()const{return Durable.load(std::memory_order_acquire);};
+    void WaitDurable(std::uint64_t Sequence)const
+    {
+        SpinBackoff Wait{};
+        while(DurableSequence()<Sequence)
+        {
+            ThrowIfFailed();
+            Wait.Pause();
+        };
+    };
+    std::uint64_t Groups()const{return GroupCount.load(std::memory_order_relaxed);};
+private:
+    int Fd{-1};
+    JournalRecord*Records{nullptr};
+    std::size_t Capacity{0};
+    //Writer-owned: records in the file. Appender-owned: records in the file or on the ring.
+    std::size_t Next{0};
+    std::uint64_t Appended{0};
+    std::unique_ptr<SpscRing<JournalRecord,1<<16>>Ring;
+    std::atomic<std::uint64_t>Durable{0};
+    std::atomic<std::uint64_t>GroupCount{0};
+    //errno of the writer's first failure, 0 while it has none.
+    std::atomic<int>WriteError{0};
+    std::atomic<bool>Stop{false};
+    std::thread Writer;
+    //Constructor failure: releases what was set up and throws.
+    [[noreturn]]void Fail(const std::string&What,int Error)
+    {
+        if(Records)munmap(Records,Capacity*sizeof(JournalRecord));
+        close(Fd);
+        throw std::system_error{Error,std::generic_category(),What};
+    };
+    void ThrowIfFailed()const
+    {
+        if(int Error{WriteError.load(std::memory_order_acquire)})throw std::system_error{Error,std::generic_category(),"BookJournal writer"};
+    };
+    //Sizes the file to Count records and maps it; returns errno on failure, leaving any old mapping in place.
+    int Map(std::size_t Count)
+    {
+        const std::size_t Bytes{Count*sizeof(JournalRecord)};
+        if(ftruncate(Fd,static_cast<off_t>(Bytes))<0)return errno;
+        void*Base{mmap(nullptr,Bytes,PROT_READ|PROT_WRITE,MAP_SHARED,Fd,0)};
+        if(Base==MAP_FAILED)return errno;
+        if(Records)munmap(Records,Capacity*sizeof(JournalRecord));
+        Records=static_cast<JournalRecord*>(Base);
+        Capacity=Count;
+        return 0;
+    };
+    void Write()
+    {
+        std::vector<JournalRecord>Group(4096);
+        const std::size_t Page{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+        for(;;)
+        {
+            bool Stopping{Stop.load(std::memory_order_acquire)};
+            std::size_t Count{Ring->PopBatch(Group.data(),Group.size())};
+            if(Count==0)
+            {
+                if(Stopping)break;
+                std::this_thread::sleep_for(std::chrono::microseconds{IdleMicroseconds});
+                continue;
+            };
+            //After a failure the ring is still drained, so the appender never blocks on it, but nothing more is
+            //written: Durable must not pass a record that is not on disk.
+            if(WriteError.load(std::memory_order_relaxed))continue;
+            //The file grows by doubling, remapped by this thread only.
+            if(Next+Count>Capacity)
+            {
+                if(int Error{Map(std::max(2*Capacity,Next+Count))})
+                {
+                    WriteError.store(Error,std::memory_order_release);
+                    continue;
+                };
+            };
+            std::memcpy(Records+Next,Group.data(),Count*sizeof(JournalRecord));
+            std::size_t Begin{Next*sizeof(JournalRecord)/Page*Page},End{(Next+Count)*sizeof(JournalRecord)};
+            if(msync(reinterpret_cast<char*>(Records)+Begin,End-Begin,MS_SYNC)<0)
+            {
+                WriteError.store(errno,std::memory_order_release);
+                continue;
+            };
+            Next+=Count;
+            GroupCount.fetch_add(1,std::memory_order_relaxed);
+            Durable.store(Next,std::memory_order_release);
+        };
+    };
+};
+
+//The update path: stamp the next sequence, apply to the book, hand to the journal.
+inline void ApplyAndJournal(PricedBook&Book,BookJournal&Journal,JournalRecord Record)
+{
+    Record.Sequence=Journal.NextSequence();
+    Book.Apply(Record);
+    Journal.Append(Record);
+};
+//Columnar snapshot of a PricedBook: a 64-byte header, then the four columns, each padded to 64 bytes, so a
+//restart maps the file and copies columns without parsing anything. Written to a temporary file, synced and
+//renamed over the previous snapshot, and the directory synced, so a crash mid-write leaves the old one intact.
+struct SnapshotHeader
+{
+    char Magic[8];
+    std::uint64_t Count;
+    std::uint64_t Sequence;
+    double Spread;
+    std::uint64_t Reserved[4];
+};
+static_assert(sizeof(SnapshotHeader)==64);
+inline std::size_t SnapshotColumnBytes(std::size_t Count){return (Count*sizeof(double)+63)/64*64;};
+//The snapshot must not run ahead of the journal, or a crash would leave it holding records the journal lost:
+//waits until Journal has made every record up to Book.Sequence durable, and fails if Book is ahead of it.
+//Throws std::system_error if the journal's writer has failed.
+inline bool WriteSnapshot(const PricedBook&Book,const BookJournal&Journal,const std::string&Path)
+{
+    if(Book.Sequence>=Journal.NextSequence())return false;
+    Journal.WaitDurable(Book.Sequence);
+    std::string Temporary{Path+".tmp"};
+    int Fd{open(Temporary.c_str(),O_WRONLY|O_CREAT|O_TRUNC|O_CLOEXEC,0644)};
+    if(Fd<0)return false;
+    SnapshotHeader Header{{'Z','C','S','N','A','P','0','1'},Book.Size(),Book.Sequence,Book.Spread,{}};
+    bool Ok{write(Fd,&Header,sizeof Header)==static_cast<ssize_t>(sizeof Header)};
+    std::vector<char>Padding(64,0);
+    for(const auto*Column:{&Book.FaceValue,&Book.InterestRate,&Book.YearFraction,&Book.Price})
+    {
+        //Large columns go in pieces; one write is capped at about 2 GB.
+        const char*Bytes{reinterpret_cast<const char*>(Column->data())};
+        std::size_t Left{Column->size()*sizeof(double)};
+        while(Ok&&Left)
+        {
+            ssize_t n{write(Fd,Bytes,std::min<std::size_t>(Left,1<<30))};
+            Ok=n>0;
+            Bytes+=n;
+            Left-=Ok?static_cast<std::size_t>(n):Left;
+        };
+        std::size_t Pad{SnapshotColumnBytes(Column->size())-Column->size()*sizeof(double)};
+        Ok=Ok&&write(Fd,Padding.data(),Pad)==static_cast<ssize_t>(Pad);
+    };
+    Ok=Ok&&fdatasync(Fd)==0;
+    close(Fd);
+    if(!Ok||rename(Temporary.c_str(),Path.c_str())!=0)return false;
+    //The rename itself is only durable once the directory is.
+    std::filesystem::path Directory{std::filesystem::path{Path}.parent_path()};
+    int DirectoryFd{open(Directory.empty()?".":Directory.c_str(),O_RDONLY|O_DIRECTORY|O_CLOEXEC)};
+    if(DirectoryFd<0)return false;
+    Ok=fsync(DirectoryFd)==0;
+    close(DirectoryFd);
+    return Ok;
+};
+//Counts from the last restart.
+struct RecoveryStats
+{
+    std::uint64_t SnapshotSequence{0};
+    std::uint64_t Replayed{0};
+    bool FullReprice{false};
+};
+//Restores a book from the latest snapshot and replays only the journal records after it. A missing snapshot
+//means an empty book and a full replay. Returns false if the snapshot is unreadable.
+inline bool RecoverBook(const std::string&SnapshotPath,const std::string&JournalPath,PricedBook&Book,RecoveryStats&Stats)
+{
+    Book=PricedBook{};
+    Stats=RecoveryStats{};
+    int Fd{open(SnapshotPath.c_str(),O_RDONLY|O_CLOEXEC)};
+    if(Fd>=0)
+    {
+        struct stat Status{};
+        fstat(Fd,&Status);
+        std::size_t Bytes{static_cast<std::size_t>(Status.st_size)};
+        void*Base{Bytes>=sizeof(SnapshotHeader)?mmap(nullptr,Bytes,PROT_READ,MAP_PRIVATE|MAP_POPULATE,Fd,0):MAP_FAILED};
+        close(Fd);
+        if(Base==MAP_FAILED)return false;
+        const SnapshotHeader&Header{*static_cast<const SnapshotHeader*>(Base)};
+        std::size_t Column{SnapshotColumnBytes(Header.Count)};
+        if(std::memcmp(Header.Magic,"ZCSNAP01",8)!=0||Bytes<sizeof(SnapshotHeader)+4*Column)
+        {
+            munmap(Base,Bytes);
+            return false;
+        };
+        const char*Data{static_cast<const char*>(Base)+sizeof(SnapshotHeader)};
+        std::size_t c{0};
+        for(auto*Out:{&Book.FaceValue,&Book.InterestRate,&Book.YearFraction,&Book.Price})
+        {
+            const double*In{reinterpret_cast<const double*>(Data+Column*c++)};
+            Out->assign(In,In+Header.Count);
+        };
+        Book.Spread=Header.Spread;
+        Book.Sequence=Header.Sequence;
+        Stats.SnapshotSequence=Header.Sequence;
+        munmap(Base,Bytes);
+    };
+    Fd=open(JournalPath.c_str(),O_RDONLY|O_CLOEXEC);
+    if(Fd<0)return true;
+    struct stat Status{};
+    fstat(Fd,&Status);
+    std::size_t Count{static_cast<std::size_t>(Status.st_size)/sizeof(JournalRecord)};
+    if(Count>Book.Sequence)
+    {
+        //Record i carries sequence i+1, so the tail starts at index Sequence; nothing before it is read.
+        std::size_t Offset{static_cast<std::size_t>(Book.Sequence)*sizeof(JournalRecord)};
+        std::size_t Page{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))},Start{Offset/Page*Page};
+        std::size_t Bytes{Count*sizeof(JournalRecord)-Start};
+        void*Base{mmap(nullptr,Bytes,PROT_READ,MAP_PRIVATE,Fd,static_cast<off_t>(Start))};
+        if(Base!=MAP_FAILED)
+        {
+            madvise(Base,Bytes,MADV_SEQUENTIAL);
+            const JournalRecord*Tail{reinterpret_cast<const JournalRecord*>(static_cast<const char*>(Base)+(Offset-Start))};
+            std::size_t Available{Count-static_cast<std::size_t>(Book.Sequence)};
+            for(std::size_t i=0;i<Available&&JournalValid(Tail[i],Book.Sequence+1);++i)
+            {
+                Stats.FullReprice=Stats.FullReprice||Tail[i].Kind==JournalKind::Spread;
+                Book.Apply(Tail[i],true);
+                ++Stats.Replayed;
+            };
+            munmap(Base,Bytes);
+        };
+    };
+    close(Fd);
+    if(Stats.FullReprice)Book.Reprice();
+    return true;
+};
+
+#endif
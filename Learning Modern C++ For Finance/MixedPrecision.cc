@@ -0,0 +1,151 @@
+#include"HistoricalVaR.h"
+#include"Exposure.h"
+#include"MultiAssetPaths.h"
+#include"Summation.h"
+#include<chrono>
+#include<random>
+#include<string>
+double Seconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+};
+template<typename Function>
+double Time(Function&&Body)
+{
+    auto Start{std::chrono::steady_clock::now()};
+    Body();
+    return Seconds(Start);
+};
+//Times are printed on an engine's first row only.
+void Report(const std::string&Engine,double Double,double Float,const std::string&Measure,double Error)
+{
+    std::cout<<std::setw(24)<<std::left<<Engine<<std::right;
+    if(Engine.empty())std::cout<<std::setw(33)<<"";
+    else std::cout<<std::setw(10)<<Double<<std::setw(10)<<Float<<std::setw(12)<<std::to_string(Double/Float).substr(0,4)+"x";
+    std::cout<<"   "<<std::setw(32)<<std::left<<Measure<<std::right<<Error<<"\n";
+};
+void VaRReport()
+{
+    const std::size_t Bonds{200000},Count{1000};
+    std::mt19937_64 Engine{11};
+    std::uniform_real_distribution<double>Maturity{0.1,30.0};
+    std::normal_distribution<double>Normal{};
+    ScenarioMatrix Scenarios{};
+    for(double t:{0.25,0.5,1.0,2.0,3.0,5.0,7.0,10.0,15.0,20.0,30.0})Scenarios.Pillars.push_back(t);
+    std::vector<ZeroCouponStruct>Book(Bonds);
+    for(std::size_t b=0;b<Bonds;++b)
+    {
+        double t{Maturity(Engine)};
+        Book[b]={1000.0*(1+b%5)*(b%3?1.0:-1.0),0.02+0.0007*t,t,0.0};
+    };
+    Scenarios.Resize(Count);
+    for(std::size_t s=0;s<Count;++s)
+    {
+        double Level{7e-4*Normal(Engine)},Slope{3e-4*Normal(Engine)};
+        for(std::size_t p=0;p<Scenarios.Pillars.size();++p)Scenarios(p,s)=Level+Slope*(Scenarios.Pillars[p]/30.0-0.5)+5e-5*Normal(Engine);
+    };
+    ZeroCouponBook Columns{};
+    Columns.Load(Book,Scenarios.Pillars);
+    HistoricalVaREngine<double>Double{};
+    HistoricalVaREngine<float>Float{};
+    double DoubleSeconds{Time([&]{Double.Revalue(Columns,Scenarios);})};
+    double FloatSeconds{Time([&]{Float.Revalue(Columns,Scenarios);})};
+    double Worst{0.0},Scale{0.0};
+    for(std::size_t s=0;s<Count;++s)
+    {
+        Worst=std::max(Worst,std::abs(Float.PnL[s]-Double.PnL[s]));
+        Scale=std::max(Scale,std::abs(Double.PnL[s]));
+    };
+    Report("Historical VaR",DoubleSeconds,FloatSeconds,"max |dPnL| / max |PnL|",Worst/Scale);
+    Report("",DoubleSeconds,FloatSeconds,"99% VaR relative difference",std::abs(Float.ValueAtRisk(0.99)/Double.ValueAtRisk(0.99)-1.0));
+};
+void ExposureReport()
+{
+    VasicekStruct Model{0.03,0.5,0.04,0.01};
+    const std::size_t Paths{5000},Trades{20000},Sets{20};
+    std::mt19937_64 Engine{5};
+    std::uniform_real_distribution<double>Uniform{0.0,1.0};
+    ExposureBook Book{};
+    for(std::size_t i=0;i<Trades;++i)
+    {
+        std::uint32_t Set{static_cast<std::uint32_t>(i%Sets)};
+        double Amount{(Uniform(Engine)<0.45?-1.0:1.0)*1e5*(1.0+9.0*Uniform(Engine))};
+        double Maturity{0.5+29.5*Uniform(Engine)};
+        if(i%10==0)
+        {
+            double Expiry{0.25+0.5*Maturity*Uniform(Engine)};
+            Book.AddOption(Set,Amount,Maturity,Expiry,VasicekZero(Model,Maturity-Expiry,Model.LongRunRate),i%20?1.0:-1.0);
+        }else Book.AddBond(Set,ZeroCouponStruct{Amount,0.0,Maturity,0.0});
+    };
+    ExposureEngine<double>Double{Model,Paths,Sets};
+    ExposureEngine<float>Float{Model,Paths,Sets};
+    for(auto*Run:{&Double.Grid,&Float.Grid})*Run={0.0,0.5,1.0,2.0,5.0};
+    Double.Hazard.assign(Sets,0.015);
+    Float.Hazard.assign(Sets,0.015);
+    double DoubleSeconds{Time([&]{Double.Run(Book,1);})};
+    double FloatSeconds{Time([&]{Float.Run(Book,1);})};
+    double WorstEE{0.0},WorstPFE{0.0},Scale{0.0},WorstCva{0.0};
+    for(std::size_t i=0;i<Double.ExpectedExposure.size();++i)
+    {
+        WorstEE=std::max(WorstEE,std::abs(Float.ExpectedExposure[i]-Double.ExpectedExposure[i]));
+        WorstPFE=std::max(WorstPFE,std::abs(Float.PotentialExposure[i]-Double.PotentialExposure[i]));
+        Scale=std::max(Scale,Double.ExpectedExposure[i]);
+    };
+    for(std::size_t Set=0;Set<Sets;++Set)WorstCva=std::max(WorstCva,std::abs(Float.Cva[Set]/Double.Cva[Set]-1.0));
+    Report("Exposure (EE/PFE/CVA)",DoubleSeconds,FloatSeconds,"max |dEE| / max EE",WorstEE/Scale);
+    Report("",DoubleSeconds,FloatSeconds,"max |dPFE| / max EE",WorstPFE/Scale);
+    Report("",DoubleSeconds,FloatSeconds,"max CVA relative difference",WorstCva);
+};
+//Five-asset basket call; the payoffs are averaged with the compensated sum in double either way.
+template<typename Real>
+double BasketCall(std::size_t Paths,double&Seconds,double&StandardError)
+{
+    const std::size_t n{5};
+    CorrelatedPathGenerator<Real>Generator{n,0.03,std::vector<double>(n,100.0),{0.2,0.25,0.3,0.35,0.4}};
+    std::vector<double>Correlation(n*n);
+    for(std::size_t i=0;i<n;++i)for(std::size_t j=0;j<n;++j)Correlation[i*n+j]=i==j?1.0:0.4;
+    Generator.SetCorrelation(Correlation);
+    std::vector<Real>LogSpot{};
+    std::vector<double>Payoff(Paths);
+    Seconds=Time([&]
+    {
+        Generator.Terminal(LogSpot,Paths,12,1.0);
+        for(std::size_t p=0;p<Paths;++p)
+        {
+            Real Basket{0};
+            for(std::size_t i=0;i<n;++i)Basket+=ExpSimd(LogSpot[i*Paths+p]);
+            Payoff[p]=std::max<double>(Basket/Real(n)-Real(100),0.0);
+        };
+    });
+    double Mean{CompensatedSum(Payoff,1)/Paths};
+    double Square{CompensatedSum(Paths,[&](std::size_t p){return Payoff[p]*Payoff[p];},1)/Paths};
+    StandardError=std::sqrt((Square-Mean*Mean)/Paths);
+    return std::exp(-0.03)*Mean;
+};
+void BasketReport()
+{
+    const std::size_t Paths{200000};
+    double DoubleSeconds,FloatSeconds,Error,Ignored;
+    double Double{BasketCall<double>(Paths,DoubleSeconds,Error)};
+    double Float{BasketCall<float>(Paths,FloatSeconds,Ignored)};
+    Report("Basket MC (5 assets)",DoubleSeconds,FloatSeconds,"|dPrice| / MC standard error",std::abs(Float-Double)/Error);
+};
+int main()
+{
+    std::cout<<std::setprecision(3);
+    std::cout<<std::setw(24)<<std::left<<"Engine"<<std::right<<std::setw(10)<<"double s"<<std::setw(10)<<"float s"<<std::setw(12)<<"speed-up"
+        <<"   accuracy of float against double\n";
+    VaRReport();
+    ExposureReport();
+    BasketReport();
+    return 0;
+};
+/*
+Runs each engine that has a float32 mode twice on the same inputs and random streams, once in double and
+once in float (accumulation in double in both), and prints the speed-up next to the accuracy lost, so a job
+can choose float where the error is below what it reports (historical VaR, exposure, basket Monte Carlo).
+The basket timing includes drawing the normals, which stays in double and dominates it.
+
+Build with
+g++ -std=c++20 -O3 -march=native -fopenmp-simd -pthread MixedPrecision.cc -o MixedPrecision
+*/
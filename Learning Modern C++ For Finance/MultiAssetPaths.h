@@ -0,0 +1,190 @@
+#ifndef MultiAssetPaths_H
+#define MultiAssetPaths_H
+#include<vector>
+#include<cmath>
+#include<random>
+#include<algorithm>
+#include<cstddef>
+#include<stdexcept>
+
+//Lower-triangular Cholesky factor of a row-major n x n correlation matrix. Returns false, leaving Lower
+//partly filled, if a pivot is not positive, i.e. the matrix is not positive definite.
+inline bool CholeskyFactor(const std::vector<double>&Correlation,std::size_t n,std::vector<double>&Lower)
+{
+    Lower.assign(n*n,0.0);
+    for(std::size_t i=0;i<n;++i)
+    {
+        for(std::size_t j=0;j<=i;++j)
+        {
+            double Sum{Correlation[i*n+j]};
+            for(std::size_t k=0;k<j;++k)Sum-=Lower[i*n+k]*Lower[j*n+k];
+            if(i==j)
+            {
+                if(!(Sum>1e-14))return false;
+                Lower[i*n+i]=std::sqrt(Sum);
+            }else Lower[i*n+j]=Sum/Lower[j*n+j];
+        };
+    };
+    return true;
+};
+//Cyclic Jacobi eigen-decomposition of a symmetric matrix: on return Matrix holds the eigenvalues on its
+//diagonal and Vectors the eigenvectors as columns.
+inline void JacobiEigen(std::vector<double>&Matrix,std::size_t n,std::vector<double>&Vectors)
+{
+    Vectors.assign(n*n,0.0);
+    for(std::size_t i=0;i<n;++i)Vectors[i*n+i]=1.0;
+    for(int Sweep=0;Sweep<100;++Sweep)
+    {
+        double Off{0.0};
+        for(std::size_t p=0;p<n;++p)for(std::size_t q=p+1;q<n;++q)Off+=Matrix[p*n+q]*Matrix[p*n+q];
+        if(Off<1e-30)break;
+        for(std::size_t p=0;p<n;++p)
+        {
+            for(std::size_t q=p+1;q<n;++q)
+            {
+                double apq{Matrix[p*n+q]};
+                if(std::abs(apq)<1e-300)continue;
+                double Tau{(Matrix[q*n+q]-Matrix[p*n+p])/(2.0*apq)};
+                double t{(Tau>=0.0?1.0:-1.0)/(std::abs(Tau)+std::sqrt(1.0+Tau*Tau))};
+                double c{1.0/std::sqrt(1.0+t*t)};
+                double s{t*c};
+                for(std::size_t k=0;k<n;++k)
+                {
+                    double akp{Matrix[k*n+p]},akq{Matrix[k*n+q]};
+                    Matrix[k*n+p]=c*akp-s*akq;
+                    Matrix[k*n+q]=s*akp+c*akq;
+                };
+                for(std::size_t k=0;k<n;++k)
+                {
+                    double apk{Matrix[p*n+k]},aqk{Matrix[q*n+k]};
+                    Matrix[p*n+k]=c*apk-s*aqk;
+                    Matrix[q*n+k]=s*apk+c*aqk;
+                };
+                for(std::size_t k=0;k<n;++k)
+                {
+                    double vkp{Vectors[k*n+p]},vkq{Vectors[k*n+q]};
+                    Vectors[k*n+p]=c*vkp-s*vkq;
+                    Vectors[k*n+q]=s*vkp+c*vkq;
+                };
+            };
+        };
+    };
+};
+//Nearest usable correlation by spectral clipping: negative eigenvalues are raised to Floor, the matrix is
+//rebuilt from the eigenvectors and rescaled back to a unit diagonal.
+inline void RepairCorrelation(std::vector<double>&Correlation,std::size_t n,double Floor=1e-8)
+{
+    std::vector<double>Eigen{Correlation},Vectors{};
+    JacobiEigen(Eigen,n,Vectors);
+    for(std::size_t i=0;i<n;++i)
+    {
+        for(std::size_t j=0;j<n;++j)
+        {
+            double Sum{0.0};
+            for(std::size_t k=0;k<n;++k)Sum+=Vectors[i*n+k]*std::max(Eigen[k*n+k],Floor)*Vectors[j*n+k];
+            Correlation[i*n+j]=Sum;
+        };
+    };
+    std::vector<double>Scale(n);
+    for(std::size_t i=0;i<n;++i)Scale[i]=1.0/std::sqrt(Correlation[i*n+i]);
+    for(std::size_t i=0;i<n;++i)for(std::size_t j=0;j<n;++j)Correlation[i*n+j]*=Scale[i]*Scale[j];
+};
+//Lognormal assets driven by correlated Brownian motions. The factor of the correlation matrix is computed
+//once in SetCorrelation and reused for every batch. Batches are asset-major, element [Asset*Paths+Path],
+//so correlating is a lower-triangular matrix times a wide matrix with unit-stride inner loops.
+//Real is the type of the draws and paths; the factor is computed in double and narrowed once, and with float
+//the normals are drawn in double and rounded, so float and double paths come from the same random stream.
+template<typename Real=double>
+struct CorrelatedPathGenerator
+{
+    std::size_t Assets;
+    double InterestRate;
+    std::vector<double>Spot;
+    std::vector<double>Volatility;
+    std::vector<double>Correlation{};
+    std::vector<double>Factor{};
+    std::vector<Real>NarrowFactor{};
+    bool Repaired{false};
+    std::size_t PathTile{128};
+    std::mt19937_64 Engine{2024};
+    std::normal_distribution<double>Normal{};
+
+    void SetCorrelation(const std::vector<double>&Matrix)
+    {
+        Correlation=Matrix;
+        Repaired=!CholeskyFactor(Correlation,Assets,Factor);
+        if(Repaired)
+        {
+            RepairCorrelation(Correlation,Assets);
+            if(!CholeskyFactor(Correlation,Assets,Factor))throw std::runtime_error{"CorrelatedPathGenerator: correlation matrix still not positive definite after repair"};
+        };
+        NarrowFactor.assign(Factor.begin(),Factor.end());
+    };
+    void Normals(std::vector<Real>&Z,std::size_t Paths)
+    {
+        Z.resize(Assets*Paths);
+        for(auto&z:Z)z=static_cast<Real>(Normal(Engine));
+    };
+    //W=L*Z in tiles of PathTile paths so a tile of Z (Assets x PathTile) stays in cache while every row of L
+    //is applied to it; each update is an axpy over the tile.
+    void Correlate(const std::vector<Real>&Z,std::vector<Real>&W,std::size_t Paths)const
+    {
+        W.assign(Assets*Paths,Real(0));
+        const Real*L{NarrowFactor.data()};
+        for(std::size_t Begin=0;Begin<Paths;Begin+=PathTile)
+        {
+            std::size_t End{std::min(Paths,Begin+PathTile)};
+            for(std::size_t i=0;i<Assets;++i)
+            {
+                Real*Out{W.data()+i*Paths};
+                for(std::size_t j=0;j<=i;++j)
+                {
+                    Real Lij{L[i*Assets+j]};
+                    const Real*In{Z.data()+j*Paths};
+                    #pragma omp simd
+                    for(std::size_t p=Begin;p<End;++p)Out[p]+=Lij*In[p];
+                };
+            };
+        };
+    };
+    //Same product one path at a time, for comparison.
+    void CorrelateNaive(const std::vector<Real>&Z,std::vector<Real>&W,std::size_t Paths)const
+    {
+        W.assign(Assets*Paths,Real(0));
+        for(std::size_t p=0;p<Paths;++p)
+        {
+            for(std::size_t i=0;i<Assets;++i)
+            {
+                Real Sum{0};
+                for(std::size_t j=0;j<=i;++j)Sum+=NarrowFactor[i*Assets+j]*Z[j*Paths+p];
+                W[i*Paths+p]=Sum;
+            };
+        };
+    };
+    //Advances log-spots LogSpot (asset-major, Assets x Paths) by one step of length dt.
+    void Step(std::vector<Real>&LogSpot,std::vector<Real>&Z,std::vector<Real>&W,std::size_t Paths,double dt)
+    {
+        Normals(Z,Paths);
+        Correlate(Z,W,Paths);
+        double RootDt{std::sqrt(dt)};
+        for(std::size_t i=0;i<Assets;++i)
+        {
+            Real Drift{static_cast<Real>((InterestRate-0.5*Volatility[i]*Volatility[i])*dt)};
+            Real Diffusion{static_cast<Real>(Volatility[i]*RootDt)};
+            Real*x{LogSpot.data()+i*Paths};
+            const Real*w{W.data()+i*Paths};
+            #pragma omp simd
+            for(std::size_t p=0;p<Paths;++p)x[p]+=Drift+Diffusion*w[p];
+        };
+    };
+    //Terminal log-spots after Steps steps to YearFraction.
+    void Terminal(std::vector<Real>&LogSpot,std::size_t Paths,std::size_t Steps,double YearFraction)
+    {
+        LogSpot.resize(Assets*Paths);
+        for(std::size_t i=0;i<Assets;++i)std::fill(LogSpot.begin()+i*Paths,LogSpot.begin()+(i+1)*Paths,static_cast<Real>(std::log(Spot[i])));
+        std::vector<Real>Z{},W{};
+        for(std::size_t s=0;s<Steps;++s)Step(LogSpot,Z,W,Paths,YearFraction/Steps);
+    };
+};
+
+#endif
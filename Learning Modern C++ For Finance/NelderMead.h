@@ -0,0 +1,83 @@
+#ifndef NelderMead_H
+#define NelderMead_H
+#include<array>
+#include<algorithm>
+#include<cmath>
+#include<cstddef>
+
+//Downhill simplex minimiser for small unconstrained problems; constraints are handled by the caller through
+//a change of variables. Starts from a simplex of side Step around Start and stops once the spread of the
+//objective over the simplex falls below Tolerance or after Iterations steps. Returns the best vertex and
+//leaves its value in Value.
+template<std::size_t Dim,typename Function>
+std::array<double,Dim> NelderMead(Function&&Objective,std::array<double,Dim>Start,double Step,int Iterations,double Tolerance,double&Value)
+{
+    std::array<std::array<double,Dim>,Dim+1>Vertex{};
+    std::array<double,Dim+1>f{};
+    for(std::size_t v=0;v<=Dim;++v)
+    {
+        Vertex[v]=Start;
+        if(v)Vertex[v][v-1]+=Step;
+        f[v]=Objective(Vertex[v]);
+    };
+    auto Blend=[](const std::array<double,Dim>&a,const std::array<double,Dim>&b,double t)
+    {
+        std::array<double,Dim>x{};
+        for(std::size_t d=0;d<Dim;++d)x[d]=a[d]+t*(b[d]-a[d]);
+        return x;
+    };
+    for(int Iteration=0;Iteration<Iterations;++Iteration)
+    {
+        //Order only the best and the two worst vertices; that is all a step needs.
+        std::size_t Best{0},Worst{0};
+        for(std::size_t v=1;v<=Dim;++v)
+        {
+            if(f[v]<f[Best])Best=v;
+            if(f[v]>f[Worst])Worst=v;
+        };
+        std::size_t Next{Best};
+        for(std::size_t v=0;v<=Dim;++v)if(v!=Worst&&f[v]>f[Next])Next=v;
+        if(f[Worst]-f[Best]<=Tolerance*(std::abs(f[Best])+1e-30))break;
+        std::array<double,Dim>Centre{};
+        for(std::size_t v=0;v<=Dim;++v)if(v!=Worst)for(std::size_t d=0;d<Dim;++d)Centre[d]+=Vertex[v][d]/Dim;
+        std::array<double,Dim>Reflected{Blend(Centre,Vertex[Worst],-1.0)};
+        double fReflected{Objective(Reflected)};
+        if(fReflected<f[Best])
+        {
+            std::array<double,Dim>Expanded{Blend(Centre,Vertex[Worst],-2.0)};
+            double fExpanded{Objective(Expanded)};
+            if(fExpanded<fReflected)
+            {
+                Vertex[Worst]=Expanded;
+                f[Worst]=fExpanded;
+            }else{
+                Vertex[Worst]=Reflected;
+                f[Worst]=fReflected;
+            };
+        }else if(fReflected<f[Next])
+        {
+            Vertex[Worst]=Reflected;
+            f[Worst]=fReflected;
+        }else{
+            bool Outside{fReflected<f[Worst]};
+            std::array<double,Dim>Contracted{Blend(Centre,Outside?Reflected:Vertex[Worst],0.5)};
+            double fContracted{Objective(Contracted)};
+            if(fContracted<(Outside?fReflected:f[Worst]))
+            {
+                Vertex[Worst]=Contracted;
+                f[Worst]=fContracted;
+            }else{
+                for(std::size_t v=0;v<=Dim;++v)if(v!=Best)
+                {
+                    Vertex[v]=Blend(Vertex[Best],Vertex[v],0.5);
+                    f[v]=Objective(Vertex[v]);
+                };
+            };
+        };
+    };
+    std::size_t Best{static_cast<std::size_t>(std::min_element(f.begin(),f.end())-f.begin())};
+    Value=f[Best];
+    return Vertex[Best];
+};
+
+#endif
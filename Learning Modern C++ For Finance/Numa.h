@@ -0,0 +1,279 @@
+#ifndef Numa_H
+#define Numa_H
+#include<vector>
+#include<string>
+#include<thread>
+#include<barrier>
+#include<chrono>
+#include<fstream>
+#include<sstream>
+#include<filesystem>
+#include<algorithm>
+#include<utility>
+#include<cctype>
+#include<cstdint>
+#include<cstddef>
+#include<sched.h>
+#include<sys/mman.h>
+#include<sys/syscall.h>
+#include<linux/mempolicy.h>
+#include<unistd.h>
+#include"ZeroCoupnBond.h"
+#include"VectorMath.h"
+#include"Summation.h"
+
+//One NUMA node as sysfs describes it: its CPUs and its distance row (10 = local).
+struct NumaNode
+{
+    int Id;
+    std::vector<int>Cpus;
+    std::vector<int>Distance;
+};
+//"0-3,8,10-11" -> {0,1,2,3,8,10,11}.
+inline std::vector<int>ParseCpuList(const std::string&List)
+{
+    std::vector<int>Cpus{};
+    std::stringstream In{List};
+    std::string Range;
+    while(std::getline(In,Range,','))
+    {
+        if(Range.empty()||Range=="\n")continue;
+        std::size_t Dash{Range.find('-')};
+        int First{std::stoi(Range.substr(0,Dash))};
+        int Last{Dash==std::string::npos?First:std::stoi(Range.substr(Dash+1))};
+        for(int Cpu=First;Cpu<=Last;++Cpu)Cpus.push_back(Cpu);
+    };
+    return Cpus;
+};
+struct NumaTopology
+{
+    std::vector<NumaNode>Nodes{};
+    //Nodes with CPUs under Root; a machine without the sysfs tree is one node holding every CPU.
+    static NumaTopology Read(const std::string&Root="/sys/devices/system/node")
+    {
+        NumaTopology Topology{};
+        std::error_code Error;
+        for(const auto&Entry:std::filesystem::directory_iterator{Root,Error})
+        {
+            std::string Name{Entry.path().filename().string()};
+            if(Name.rfind("node",0)!=0||Name.size()==4||!std::isdigit(static_cast<unsigned char>(Name[4])))continue;
+            NumaNode Node{std::stoi(Name.substr(4)),{},{}};
+            std::ifstream CpuList{Entry.path()/"cpulist"},Distance{Entry.path()/"distance"};
+            std::string Line;
+            std::getline(CpuList,Line);
+            Node.Cpus=ParseCpuList(Line);
+            for(int d;Distance>>d;)Node.Distance.push_back(d);
+            if(!Node.Cpus.empty())Topology.Nodes.push_back(Node);
+        };
+        std::sort(Topology.Nodes.begin(),Topology.Nodes.end(),[](const NumaNode&a,const NumaNode&b){return a.Id<b.Id;});
+        if(Topology.Nodes.empty())
+        {
+            NumaNode Node{0,{},{10}};
+            for(unsigned Cpu=0;Cpu<std::max(1u,std::thread::hardware_concurrency());++Cpu)Node.Cpus.push_back(static_cast<int>(Cpu));
+            Topology.Nodes.push_back(Node);
+        };
+        return Topology;
+    };
+    std::size_t CpuCount()const
+    {
+        std::size_t Count{0};
+        for(const auto&Node:Nodes)Count+=Node.Cpus.size();
+        return Count;
+    };
+};
+//Pins the calling thread to one CPU.
+inline bool PinThreadToCpu(int Cpu)
+{
+    cpu_set_t Set;
+    CPU_ZERO(&Set);
+    CPU_SET(Cpu,&Set);
+    return sched_setaffinity(0,sizeof Set,&Set)==0;
+};
+//Sets the policy for pages not yet touched in [Address,Address+Bytes): MPOL_BIND, MPOL_PREFERRED or
+//MPOL_INTERLEAVE over the given node ids. glibc has no wrapper, so this is the raw system call.
+inline bool BindPages(void*Address,std::size_t Bytes,int Mode,const std::vector<int>&NodeIds)
+{
+    std::vector<unsigned long>Mask(16,0);
+    for(int Id:NodeIds)Mask[Id/64]|=1ul<<(Id%64);
+    return syscall(SYS_mbind,Address,Bytes,Mode,Mask.data(),Mask.size()*64+1,0)==0;
+};
+//Where the pages of a range actually are, sampling every Stride-th page: counts by node id.
+inline std::vector<std::size_t>PagesByNode(const void*Address,std::size_t Bytes,std::size_t Stride=16)
+{
+    const std::size_t Page{static_cast<std::size_t>(sysconf(_SC_PAGESIZE))};
+    std::vector<void*>Pages{};
+    for(std::size_t Offset=0;Offset<Bytes;Offset+=Stride*Page)Pages.push_back(const_cast<char*>(static_cast<const char*>(Address))+Offset);
+    std::vector<int>Status(Pages.size(),-1);
+    std::vector<std::size_t>Count{};
+    if(syscall(SYS_move_pages,0,Pages.size(),Pages.data(),nullptr,Status.data(),0)!=0)return Count;
+    for(int Node:Status)if(Node>=0)
+    {
+        if(static_cast<std::size_t>(Node)>=Count.size())Count.resize(Node+1,0);
+        ++Count[Node];
+    };
+    return Count;
+};
+//Starts one thread per CPU of the topology, pinned to it, and calls Body(Node,Rank,Ranks) where Node is
+//the index into Topology.Nodes and Rank counts the thread among the Ranks threads of that node.
+template<typename Function>
+void RunPinned(const NumaTopology&Topology,Function&&Body)
+{
+    std::vector<std::thread>Workers{};
+    Workers.reserve(Topology.CpuCount());
+    for(std::size_t n=0;n<Topology.Nodes.size();++n)
+    {
+        const std::vector<int>&Cpus{Topology.Nodes[n].Cpus};
+        for(std::size_t Rank=0;Rank<Cpus.size();++Rank)Workers.emplace_back([&Body,n,Rank,Cpu=Cpus[Rank],Ranks=Cpus.size()]
+        {
+            PinThreadToCpu(Cpu);
+            Body(n,Rank,Ranks);
+        });
+    };
+    for(auto&Worker:Workers)Worker.join();
+};
+
+//Where a node's partition of the book lives relative to the threads that price it.
+enum class Placement{Local,Interleaved,Remote};
+//Zero-coupon book split into one contiguous partition per NUMA node, sized by its CPU count. Each
+//partition's columns are one anonymous mapping that nothing touches until Load, so the pinned thread that
+//first writes a page decides its node: the partition's own threads for Local, the next node's threads for
+//Remote, and an interleave policy across all nodes for Interleaved. Pricing always runs on the partition's
+//own node, so the three placements differ only in where the bytes come from.
+class NumaZeroCouponBook
+{
+public:
+    struct Partition
+    {
+        std::size_t Begin;
+        std::size_t End;
+        void*Base;
+        std::size_t Bytes;
+        double*FaceValue;
+        double*InterestRate;
+        double*YearFraction;
+        double*Price;
+        //Filled by Price(): wall time of the node's slowest thread, and the pages seen on each node.
+        double Seconds;
+        std::vector<std::size_t>Pages;
+    };
+    NumaTopology Topology;
+    std::vector<Partition>Partitions{};
+    explicit NumaZeroCouponBook(NumaTopology Topology):Topology{std::move(Topology)}{};
+    ~NumaZeroCouponBook(){Release();};
+    NumaZeroCouponBook(const NumaZeroCouponBook&)=delete;
+    NumaZeroCouponBook&operator=(const NumaZeroCouponBook&)=delete;
+    void Load(const std::vector<ZeroCouponStruct>&Book,Placement Where)
+    {
+        Release();
+        const std::size_t Nodes{Topology.Nodes.size()},Cpus{Topology.CpuCount()};
+        std::vector<int>All{};
+        for(const auto&Node:Topology.Nodes)All.push_back(Node.Id);
+        std::size_t Begin{0},Before{0};
+        for(std::size_t n=0;n<Nodes;++n)
+        {
+            Before+=Topology.Nodes[n].Cpus.size();
+            std::size_t End{Book.size()*Before/Cpus};
+            std::size_t Column{((End-Begin)*sizeof(double)+4095)/4096*4096};
+            Partition Part{Begin,End,nullptr,4*Column,nullptr,nullptr,nullptr,nullptr,0.0,{}};
+            Part.Base=mmap(nullptr,Part.Bytes,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+            char*Base{static_cast<char*>(Part.Base)};
+            Part.FaceValue=reinterpret_cast<double*>(Base);
+            Part.InterestRate=reinterpret_cast<double*>(Base+Column);
+            Part.YearFraction=reinterpret_cast<double*>(Base+2*Column);
+            Part.Price=reinterpret_cast<double*>(Base+3*Column);
+            if(Where==Placement::Interleaved)BindPages(Part.Base,Part.Bytes,MPOL_INTERLEAVE,All);
+            Partitions.push_back(Part);
+            Begin=End;
+        };
+        RunPinned(Topology,[&](std::size_t n,std::size_t Rank,std::size_t Ranks)
+        {
+            //Node n's threads write the partition they are meant to hold: their own, or for Remote the
+            //previous node's, so each partition ends up on the node after the one that prices it.
+            Partition&Part{Partitions[Where==Placement::Remote?(n+Nodes-1)%Nodes:n]};
+            auto[First,Last]=Slice(Part,Rank,Ranks);
+            for(std::size_t i=First;i<Last;++i)
+            {
+                const ZeroCouponStruct&Bond{Book[Part.Begin+i]};
+                Part.FaceValue[i]=Bond.FaceValue;
+                Part.InterestRate[i]=Bond.InterestRate;
+                Part.YearFraction[i]=Bond.YearFraction;
+                Part.Price[i]=0.0;
+            };
+        });
+        for(auto&Part:Partitions)Part.Pages=PagesByNode(Part.Base,Part.Bytes);
+    };
+    //Prices the book Repeats times under a parallel rate shift with every node's threads on their own
+    //partition and returns the book value. The value is summed in the fixed blocks of Summation.h over book
+    //rows, each block by the thread holding its first row, and folded in book order, so it has the same bits
+    //as CompensatedSum over the prices for any node and CPU count.
+    double Price(double Shift,int Repeats=1)
+    {
+        const std::size_t Threads{Topology.CpuCount()};
+        const std::size_t Rows{Partitions.empty()?0:Partitions.back().End};
+        std::vector<NeumaierAccumulator>Parts((Rows+SumBlock-1)/SumBlock);
+        std::vector<double>Elapsed(Threads*8,0.0);
+        std::vector<std::size_t>First(Topology.Nodes.size(),0);
+        for(std::size_t n=1;n<First.size();++n)First[n]=First[n-1]+Topology.Nodes[n-1].Cpus.size();
+        std::barrier Start{static_cast<std::ptrdiff_t>(Threads)};
+        RunPinned(Topology,[&](std::size_t n,std::size_t Rank,std::size_t Ranks)
+        {
+            Partition&Part{Partitions[n]};
+            auto[Begin,End]=Slice(Part,Rank,Ranks);
+            const double*Face{Part.FaceValue},*Rate{Part.InterestRate},*Years{Part.YearFraction};
+            double*Price{Part.Price};
+            Start.arrive_and_wait();
+            auto Clock{std::chrono::steady_clock::now()};
+            for(int r=0;r<Repeats;++r)
+            {
+                #pragma omp simd
+                for(std::size_t i=Begin;i<End;++i)Price[i]=Face[i]*ExpSimd(-(Rate[i]+Shift)*Years[i]);
+            };
+            //Slots are a cache line apart so the threads do not share one.
+            Elapsed[8*(First[n]+Rank)]=std::chrono::duration<double>(std::chrono::steady_clock::now()-Clock).count();
+            //Blocks run past slices and partitions, so every price must be written first.
+            Start.arrive_and_wait();
+            for(std::size_t b=(Part.Begin+Begin+SumBlock-1)/SumBlock;b*SumBlock<Part.Begin+End;++b)
+                Parts[b]=BlockSum(b*SumBlock,std::min(Rows,(b+1)*SumBlock));
+        });
+        for(std::size_t n=0;n<Partitions.size();++n)
+        {
+            Partitions[n].Seconds=0.0;
+            for(std::size_t Rank=0;Rank<Topology.Nodes[n].Cpus.size();++Rank)
+                Partitions[n].Seconds=std::max(Partitions[n].Seconds,Elapsed[8*(First[n]+Rank)]);
+        };
+        return FoldBlocks<true>(Parts);
+    };
+private:
+    //Rows of a partition owned by one of its node's threads, in whole cache lines.
+    static std::pair<std::size_t,std::size_t>Slice(const Partition&Part,std::size_t Rank,std::size_t Ranks)
+    {
+        std::size_t Rows{Part.End-Part.Begin},Lines{(Rows+7)/8};
+        return {std::min(Rows,Lines*Rank/Ranks*8),std::min(Rows,Lines*(Rank+1)/Ranks*8)};
+    };
+    //Compensated sum of the prices of book rows [Begin,End), lanes as in Summation.h. A block that crosses a
+    //partition boundary is gathered first.
+    NeumaierAccumulator BlockSum(std::size_t Begin,std::size_t End)const
+    {
+        auto Part{std::upper_bound(Partitions.begin(),Partitions.end(),Begin,[](std::size_t Row,const Partition&p){return Row<p.End;})};
+        if(End<=Part->End)
+        {
+            auto ValueOf{[Price=Part->Price-Part->Begin](std::size_t i){return Price[i];}};
+            return SumOneBlock<true>(Begin,End,ValueOf);
+        };
+        double Gathered[SumBlock];
+        for(std::size_t i=Begin;i<End;++i)
+        {
+            while(i>=Part->End)++Part;
+            Gathered[i-Begin]=Part->Price[i-Part->Begin];
+        };
+        auto ValueOf{[&](std::size_t i){return Gathered[i];}};
+        return SumOneBlock<true>(0,End-Begin,ValueOf);
+    };
+    void Release()
+    {
+        for(auto&Part:Partitions)munmap(Part.Base,Part.Bytes);
+        Partitions.clear();
+    };
+};
+
+#endif
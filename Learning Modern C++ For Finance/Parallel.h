@@ -0,0 +1,36 @@
+#ifndef Parallel_H
+#define Parallel_H
+#include<thread>
+#include<vector>
+#include<algorithm>
+#include<cstddef>
+
+inline unsigned ThreadCount()
+{
+    unsigned Count{std::thread::hardware_concurrency()};
+    return Count==0?1:Count;
+};
+//Splits [0,Count) into one contiguous chunk per thread and calls Body(Begin,End) on each.
+//Chunks are rounded to Grain so SIMD loops inside Body never straddle two threads.
+template<typename Function>
+void ParallelFor(std::size_t Count,Function&&Body,unsigned Threads=ThreadCount(),std::size_t Grain=64)
+{
+    std::size_t Chunks{(Count+Grain-1)/Grain};
+    Threads=static_cast<unsigned>(std::min<std::size_t>(Threads,Chunks));
+    if(Threads<=1)
+    {
+        if(Count)Body(std::size_t{0},Count);
+        return;
+    };
+    std::vector<std::thread>Workers{};
+    Workers.reserve(Threads);
+    for(unsigned Thread=0;Thread<Threads;++Thread)
+    {
+        std::size_t Begin{std::min(Count,Chunks*Thread/Threads*Grain)};
+        std::size_t End{std::min(Count,Chunks*(Thread+1)/Threads*Grain)};
+        Workers.emplace_back([&Body,Begin,End]{if(Begin<End)Body(Begin,End);});
+    };
+    for(auto&Worker:Workers)Worker.join();
+};
+
+#endif
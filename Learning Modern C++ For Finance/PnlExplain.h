@@ -0,0 +1,370 @@
+#ifndef PnlExplain_H
+#define PnlExplain_H
+#include<vector>
+#include<thread>
+#include<atomic>
+#include<chrono>
+#include<numeric>
+#include<algorithm>
+#include<cmath>
+#include<cstdint>
+#include<cstddef>
+#include<stdexcept>
+#include<pthread.h>
+#include"ZeroCoupnBond.h"
+#include"BlackScholes.h"
+#include"Queue.h"
+#include"Summation.h"
+
+constexpr std::size_t ExplainDesks{8};
+constexpr std::size_t ExplainCurves{16};
+constexpr std::size_t ExplainUnderlyings{64};
+//Market since yesterday's close: Time elapsed in years, absolute zero-rate shifts per curve bucket, relative
+//spot returns and absolute volatility shifts per underlying.
+struct MarketMove
+{
+    std::uint64_t Tick;
+    double Time;
+    double Rate[ExplainCurves];
+    double Spot[ExplainUnderlyings];
+    double Volatility[ExplainUnderlyings];
+};
+//Taylor attribution of one tick's PnL per desk. Explained is the sum of the other terms.
+struct ExplainSnapshot
+{
+    static constexpr std::size_t Carry{0},RateDelta{1},RateGamma{2},SpotDelta{3},SpotGamma{4},Vol{5},Explained{6},Terms{7};
+    std::uint64_t Tick;
+    std::uint32_t Desks;
+    double Term[ExplainDesks][Terms];
+};
+//Full revaluation of the book under one tick's market, the row-level Taylor total and what it leaves
+//unexplained.
+struct ResidualSnapshot
+{
+    std::uint64_t Tick;
+    std::uint32_t Desks;
+    double Seconds;
+    double FullPnl[ExplainDesks];
+    double Explained[ExplainDesks];
+    double Residual[ExplainDesks];
+};
+
+//PnL explain for zero-coupon bonds and Black-Scholes options. Close() fixes yesterday's sensitivities in
+//columns, ordered by desk so each desk's terms are plain contiguous reductions: carry (theta per year),
+//rate delta and gamma, cash spot delta (Delta*S) and gamma (Gamma*S^2) and vega, all times quantity.
+//AttributeRows is one fused pass over them, gathering each row's factor moves from the small MarketMove
+//arrays, with no exp or normal CDF in it. Moves are per curve bucket and underlying, so every term is linear
+//in sums of row sensitivities per (desk, factor); Close() also forms those sums, and a tick attributes from
+//them in a few hundred multiply-adds instead of streaming every row. Every desk aggregate is summed the way
+//Summation.h does it, so the published figures do not depend on the SIMD width or thread count they were
+//computed with. Desks, curve buckets and underlyings are ids below ExplainDesks, ExplainCurves and
+//ExplainUnderlyings. Results go out through SeqlockCells that readers poll; a SCHED_IDLE thread takes the
+//latest move, revalues the book in full and publishes the residual against the row-level attribution, so it
+//only runs when ticks leave a core idle.
+class PnlExplainEngine
+{
+public:
+    SeqlockCell<ExplainSnapshot>Explained{};
+    SeqlockCell<ResidualSnapshot>Residuals{};
+    PnlExplainEngine()=default;
+    PnlExplainEngine(const PnlExplainEngine&)=delete;
+    PnlExplainEngine&operator=(const PnlExplainEngine&)=delete;
+    ~PnlExplainEngine(){StopChecker();};
+    void AddBond(std::uint32_t Desk,std::uint32_t Curve,double Quantity,const ZeroCouponStruct&Bond)
+    {
+        CheckIds(Desk,Curve,0);
+        Staged.push_back({Desk,Curve,0,Quantity,Bond.FaceValue,0.0,Bond.InterestRate,Bond.YearFraction,0.0,0.0});
+    };
+    void AddOption(std::uint32_t Desk,std::uint32_t Curve,std::uint32_t Underlying,double Quantity,const OptionStruct&Option)
+    {
+        CheckIds(Desk,Curve,Underlying);
+        Staged.push_back({Desk,Curve,Underlying,Quantity,Option.Spot,Option.Strike,Option.InterestRate,Option.YearFraction,Option.Volatility,Option.Theta});
+    };
+    //Yesterday's close: lays out the columns, computes values and sensitivities and starts the residual check.
+    //The previous close's check is stopped first, as it reads the columns.
+    void Close()
+    {
+        StopChecker();
+        std::vector<std::size_t>Order(Staged.size());
+        std::iota(Order.begin(),Order.end(),std::size_t{0});
+        std::stable_sort(Order.begin(),Order.end(),[&](std::size_t a,std::size_t b)
+        {
+            return Staged[a].Desk!=Staged[b].Desk?Staged[a].Desk<Staged[b].Desk:Staged[a].Theta==0.0&&Staged[b].Theta!=0.0;
+        });
+        std::size_t n{Order.size()};
+        for(auto*Column:{&Quantity,&Spot,&Strike,&Rate,&Years,&Volatility,&Theta,&Value,&Carry,&RateDelta,&RateGamma,&CashDelta,&CashGamma,&Vega})Column->resize(n);
+        Curve.resize(n);
+        Underlying.resize(n);
+        Desks=0;
+        for(std::size_t i=0;i<n;++i)
+        {
+            const Position&p{Staged[Order[i]]};
+            Curve[i]=p.Curve;
+            Underlying[i]=p.Underlying;
+            Quantity[i]=p.Quantity;
+            Spot[i]=p.Spot;
+            Strike[i]=p.Strike;
+            Rate[i]=p.Rate;
+            Years[i]=p.Years;
+            Volatility[i]=p.Volatility;
+            Theta[i]=p.Theta;
+            Desks=std::max<std::size_t>(Desks,p.Desk+1);
+        };
+        DeskBegin.assign(Desks+1,n);
+        OptionBegin.assign(Desks,n);
+        for(std::size_t d=0,i=0;d<Desks;++d)
+        {
+            DeskBegin[d]=i;
+            while(i<n&&Staged[Order[i]].Desk==d&&Theta[i]==0.0)++i;
+            OptionBegin[d]=i;
+            while(i<n&&Staged[Order[i]].Desk==d)++i;
+        };
+        for(std::size_t i=0;i<n;++i)
+        {
+            if(Theta[i]==0.0)BondSensitivities(i);
+            else OptionSensitivities(i);
+        };
+        DeskCarry.assign(Desks,0.0);
+        for(std::size_t d=0;d<Desks;++d)DeskCarry[d]=CompensatedSum(DeskBegin[d+1]-DeskBegin[d],[&,Begin=DeskBegin[d]](std::size_t i){return Carry[Begin+i];});
+        //Scattered by factor, so compensated accumulators added to in row order.
+        std::vector<NeumaierAccumulator>Rate(2*Desks*ExplainCurves),Spot(3*Desks*ExplainUnderlyings);
+        for(std::size_t d=0;d<Desks;++d)for(std::size_t i=DeskBegin[d];i<DeskBegin[d+1];++i)
+        {
+            std::size_t c{2*(d*ExplainCurves+Curve[i])},u{3*(d*ExplainUnderlyings+Underlying[i])};
+            Rate[c].Add(RateDelta[i]);
+            Rate[c+1].Add(RateGamma[i]);
+            Spot[u].Add(CashDelta[i]);
+            Spot[u+1].Add(CashGamma[i]);
+            Spot[u+2].Add(Vega[i]);
+        };
+        for(auto*Column:{&CurveDelta,&CurveGamma})Column->resize(Desks*ExplainCurves);
+        for(auto*Column:{&UnderlyingDelta,&UnderlyingGamma,&UnderlyingVega})Column->resize(Desks*ExplainUnderlyings);
+        for(std::size_t k=0;k<Desks*ExplainCurves;++k)
+        {
+            CurveDelta[k]=Rate[2*k].Total();
+            CurveGamma[k]=Rate[2*k+1].Total();
+        };
+        for(std::size_t k=0;k<Desks*ExplainUnderlyings;++k)
+        {
+            UnderlyingDelta[k]=Spot[3*k].Total();
+            UnderlyingGamma[k]=Spot[3*k+1].Total();
+            UnderlyingVega[k]=Spot[3*k+2].Total();
+        };
+        Staged.clear();
+        //Moves published before this close belong to the old book.
+        Checker=std::thread{[this,Seen=Latest.Version()]{CheckResiduals(Seen);}};
+    };
+    std::size_t Size()const{return Quantity.size();};
+    //Attributes the move, publishes the snapshot and hands the move to the residual check.
+    void Tick(const MarketMove&Move)
+    {
+        ExplainSnapshot Snapshot{};
+        Attribute(Move,Snapshot);
+        Explained.Publish(Snapshot);
+        Latest.Publish(Move);
+    };
+    //Attribution from the per-(desk, factor) sensitivities: what a tick runs.
+    void Attribute(const MarketMove&Move,ExplainSnapshot&Out)const
+    {
+        Out.Tick=Move.Tick;
+        Out.Desks=static_cast<std::uint32_t>(Desks);
+        for(std::size_t d=0;d<Desks;++d)
+        {
+            const double*rd{CurveDelta.data()+d*ExplainCurves},*rg{CurveGamma.data()+d*ExplainCurves};
+            const double*sd{UnderlyingDelta.data()+d*ExplainUnderlyings},*sg{UnderlyingGamma.data()+d*ExplainUnderlyings};
+            const double*vg{UnderlyingVega.data()+d*ExplainUnderlyings};
+            const double*dr{Move.Rate},*Return{Move.Spot},*dv{Move.Volatility};
+            double Delta{FactorSum(ExplainCurves,[&](std::size_t c){return rd[c]*dr[c];})};
+            double Gamma{FactorSum(ExplainCurves,[&](std::size_t c){return rg[c]*dr[c]*dr[c];})};
+            double Cash{FactorSum(ExplainUnderlyings,[&](std::size_t u){return sd[u]*Return[u];})};
+            double Convexity{FactorSum(ExplainUnderlyings,[&](std::size_t u){return sg[u]*Return[u]*Return[u];})};
+            double Vol{FactorSum(ExplainUnderlyings,[&](std::size_t u){return vg[u]*dv[u];})};
+            Terms(Out.Term[d],DeskCarry[d]*Move.Time,Delta,Gamma,Cash,Convexity,Vol);
+        };
+    };
+    //The same attribution row by row in one pass: each block of SumBlock rows of a desk fills the six terms'
+    //compensated lanes together, and the blocks are folded per term as CompensatedSum would.
+    void AttributeRows(const MarketMove&Move,ExplainSnapshot&Out,unsigned Threads=1)const
+    {
+        Out.Tick=Move.Tick;
+        Out.Desks=static_cast<std::uint32_t>(Desks);
+        for(std::size_t d=0;d<Desks;++d)
+        {
+            const std::size_t b{DeskBegin[d]},n{DeskBegin[d+1]-b},Blocks{(n+SumBlock-1)/SumBlock};
+            std::vector<NeumaierAccumulator>Parts[RowTerms];
+            for(auto&Part:Parts)Part.resize(Blocks);
+            ParallelFor(Blocks,[&](std::size_t Begin,std::size_t End)
+            {
+                for(std::size_t k=Begin;k<End;++k)AttributeBlock(Move,b+k*SumBlock,b+std::min(n,(k+1)*SumBlock),Parts,k);
+            },Threads,1);
+            double Total[RowTerms];
+            for(std::size_t t=0;t<RowTerms;++t)Total[t]=FoldBlocks<true>(Parts[t]);
+            Terms(Out.Term[d],Total[0]*Move.Time,Total[1],Total[2],Total[3],Total[4],Total[5]);
+        };
+    };
+    //Full PnL per desk: every row repriced with the exact formulas under the move, less its close value.
+    void Revalue(const MarketMove&Move,double*FullPnl,unsigned Threads=1)const
+    {
+        for(std::size_t d=0;d<Desks;++d)
+        {
+            FullPnl[d]=CompensatedSum(DeskBegin[d+1]-DeskBegin[d],[&,b=DeskBegin[d],Options=OptionBegin[d]](std::size_t k)
+            {
+                std::size_t i{b+k};
+                if(i<Options)
+                {
+                    ZeroCouponStruct Bond{Spot[i],Rate[i]+Move.Rate[Curve[i]],Years[i]-Move.Time,0.0};
+                    ZeroCouponBond(Bond);
+                    return Quantity[i]*Bond.Price-Value[i];
+                };
+                OptionStruct Option{Spot[i]*(1.0+Move.Spot[Underlying[i]]),Strike[i],Rate[i]+Move.Rate[Curve[i]],Years[i]-Move.Time,
+                    Volatility[i]+Move.Volatility[Underlying[i]],Theta[i],0.0};
+                BlackScholes(Option);
+                return Quantity[i]*Option.Price-Value[i];
+            },Threads);
+        };
+    };
+private:
+    struct Position
+    {
+        std::uint32_t Desk;
+        std::uint32_t Curve;
+        std::uint32_t Underlying;
+        double Quantity;
+        double Spot;
+        double Strike;
+        double Rate;
+        double Years;
+        double Volatility;
+        double Theta;
+    };
+    std::vector<Position>Staged{};
+    std::size_t Desks{0};
+    //Rows [DeskBegin[d],DeskBegin[d+1]) are desk d: bonds first, options from OptionBegin[d].
+    std::vector<std::size_t>DeskBegin{},OptionBegin{};
+    std::vector<std::uint32_t>Curve{},Underlying{};
+    //Close inputs; a bond's face value is kept in Spot.
+    std::vector<double>Quantity{},Spot{},Strike{},Rate{},Years{},Volatility{},Theta{};
+    //Close value and sensitivities, times quantity.
+    std::vector<double>Value{},Carry{},RateDelta{},RateGamma{},CashDelta{},CashGamma{},Vega{};
+    //Row sensitivities summed per desk, [Desk*ExplainCurves+Curve] and [Desk*ExplainUnderlyings+Underlying].
+    std::vector<double>DeskCarry{},CurveDelta{},CurveGamma{},UnderlyingDelta{},UnderlyingGamma{},UnderlyingVega{};
+    SeqlockCell<MarketMove>Latest{};
+    std::atomic<bool>Stop{false};
+    std::thread Checker{};
+    //The factor counts fit in one block of Summation.h, so CompensatedSum is that block's sum: taken directly,
+    //without the block list it would allocate on every tick.
+    static_assert(ExplainCurves<=SumBlock&&ExplainUnderlyings<=SumBlock);
+    //Terms of the row-level pass: carry, rate delta and gamma, spot delta and gamma, vega.
+    static constexpr std::size_t RowTerms{6};
+    template<typename Function>
+    static double FactorSum(std::size_t Count,Function&&ValueOf){return SumOneBlock<true>(0,Count,ValueOf).Total();};
+    static void CheckIds(std::uint32_t Desk,std::uint32_t Curve,std::uint32_t Underlying)
+    {
+        if(Desk>=ExplainDesks)throw std::invalid_argument{"PnlExplainEngine: desk id not below ExplainDesks"};
+        if(Curve>=ExplainCurves)throw std::invalid_argument{"PnlExplainEngine: curve id not below ExplainCurves"};
+        if(Underlying>=ExplainUnderlyings)throw std::invalid_argument{"PnlExplainEngine: underlying id not below ExplainUnderlyings"};
+    };
+    //Rows [Begin,End), one block of a desk: row Begin+i goes to lane i%SumLanes of every term, so each term's
+    //block sum is bit-identical to SumOneBlock<true> over its own column.
+    void AttributeBlock(const MarketMove&Move,std::size_t Begin,std::size_t End,std::vector<NeumaierAccumulator>*Parts,std::size_t Block)const
+    {
+        const double*__restrict dr{Move.Rate},*__restrict Return{Move.Spot},*__restrict dv{Move.Volatility};
+        const std::uint32_t*__restrict c{Curve.data()},*__restrict u{Underlying.data()};
+        const double*__restrict th{Carry.data()},*__restrict rd{RateDelta.data()},*__restrict rg{RateGamma.data()};
+        const double*__restrict sd{CashDelta.data()},*__restrict sg{CashGamma.data()},*__restrict vg{Vega.data()};
+        double Sum[RowTerms][SumLanes]{},Carried[RowTerms][SumLanes]{};
+        auto Row=[&](std::size_t i,std::size_t Lane)
+        {
+            double Shift{dr[c[i]]},Jump{Return[u[i]]};
+            AddToLane<true>(Sum[0][Lane],Carried[0][Lane],th[i]);
+            AddToLane<true>(Sum[1][Lane],Carried[1][Lane],rd[i]*Shift);
+            AddToLane<true>(Sum[2][Lane],Carried[2][Lane],rg[i]*Shift*Shift);
+            AddToLane<true>(Sum[3][Lane],Carried[3][Lane],sd[i]*Jump);
+            AddToLane<true>(Sum[4][Lane],Carried[4][Lane],sg[i]*Jump*Jump);
+            AddToLane<true>(Sum[5][Lane],Carried[5][Lane],vg[i]*dv[u[i]]);
+        };
+        std::size_t i{Begin};
+        for(;i+SumLanes<=End;i+=SumLanes)
+        {
+            #pragma omp simd
+            for(std::size_t Lane=0;Lane<SumLanes;++Lane)Row(i+Lane,Lane);
+        };
+        for(std::size_t Lane=0;i+Lane<End;++Lane)Row(i+Lane,Lane);
+        for(std::size_t t=0;t<RowTerms;++t)Parts[t][Block]=FoldLanes<true>(Sum[t],Carried[t]);
+    };
+    static void Terms(double*Term,double Time,double Delta,double Gamma,double Cash,double Convexity,double Vol)
+    {
+        Term[ExplainSnapshot::Carry]=Time;
+        Term[ExplainSnapshot::RateDelta]=Delta;
+        Term[ExplainSnapshot::RateGamma]=0.5*Gamma;
+        Term[ExplainSnapshot::SpotDelta]=Cash;
+        Term[ExplainSnapshot::SpotGamma]=0.5*Convexity;
+        Term[ExplainSnapshot::Vol]=Vol;
+        Term[ExplainSnapshot::Explained]=0.0;
+        for(std::size_t t=0;t<ExplainSnapshot::Explained;++t)Term[ExplainSnapshot::Explained]+=Term[t];
+    };
+    //V=F exp(-rT): carry rV as T runs down, dV/dr=-TV, d2V/dr2=T^2 V.
+    void BondSensitivities(std::size_t i)
+    {
+        double v{Quantity[i]*Spot[i]*std::exp(-Rate[i]*Years[i])};
+        Value[i]=v;
+        Carry[i]=Rate[i]*v;
+        RateDelta[i]=-Years[i]*v;
+        RateGamma[i]=Years[i]*Years[i]*v;
+        CashDelta[i]=CashGamma[i]=Vega[i]=0.0;
+    };
+    void OptionSensitivities(std::size_t i)
+    {
+        double S{Spot[i]},K{Strike[i]},r{Rate[i]},T{Years[i]},Sigma{Volatility[i]},w{Theta[i]},q{Quantity[i]};
+        double Root{std::sqrt(T)},Discount{std::exp(-r*T)};
+        double d1{(std::log(S/K)+(r+0.5*Sigma*Sigma)*T)/(Sigma*Root)},d2{d1-Sigma*Root};
+        double Nd2{NormalCdf(w*d2)},Pdf1{NormalPdf(d1)},Pdf2{NormalPdf(d2)};
+        Value[i]=q*w*(S*NormalCdf(w*d1)-K*Discount*Nd2);
+        //Calendar theta, rho and its derivative in r (d d2/dr = sqrt(T)/sigma).
+        Carry[i]=q*(-S*Pdf1*Sigma/(2.0*Root)-w*r*K*Discount*Nd2);
+        RateDelta[i]=q*w*K*T*Discount*Nd2;
+        RateGamma[i]=q*K*T*Discount*(-w*T*Nd2+Pdf2*Root/Sigma);
+        CashDelta[i]=q*w*NormalCdf(w*d1)*S;
+        CashGamma[i]=q*S*Pdf1/(Sigma*Root);
+        Vega[i]=q*S*Pdf1*Root;
+    };
+    void StopChecker()
+    {
+        Stop.store(true,std::memory_order_relaxed);
+        if(Checker.joinable())Checker.join();
+        Stop.store(false,std::memory_order_relaxed);
+    };
+    //Background loop at SCHED_IDLE: revalue the latest move whenever one newer than Seen has been published.
+    void CheckResiduals(std::uint64_t Seen)
+    {
+        sched_param Priority{};
+        pthread_setschedparam(pthread_self(),SCHED_IDLE,&Priority);
+        MarketMove Move;
+        while(!Stop.load(std::memory_order_relaxed))
+        {
+            std::uint64_t Version{Latest.Version()};
+            if(Version==Seen||!Latest.TryRead(Move))
+            {
+                std::this_thread::sleep_for(std::chrono::microseconds{200});
+                continue;
+            };
+            Seen=Version;
+            auto Start{std::chrono::steady_clock::now()};
+            ResidualSnapshot Snapshot{};
+            ExplainSnapshot Taylor{};
+            AttributeRows(Move,Taylor);
+            Revalue(Move,Snapshot.FullPnl);
+            Snapshot.Tick=Move.Tick;
+            Snapshot.Desks=static_cast<std::uint32_t>(Desks);
+            for(std::size_t d=0;d<Desks;++d)
+            {
+                Snapshot.Explained[d]=Taylor.Term[d][ExplainSnapshot::Explained];
+                Snapshot.Residual[d]=Snapshot.FullPnl[d]-Snapshot.Explained[d];
+            };
+            Snapshot.Seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+            Residuals.Publish(Snapshot);
+        };
+    };
+};
+
+#endif
@@ -0,0 +1,123 @@
+#include"PriceCache.h"
+#include"BinomialLattice.h"
+#include"Parallel.h"
+#include<random>
+#include<chrono>
+double Seconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+};
+//Skewed request stream over Distinct instruments: a few are asked for constantly, most rarely.
+std::vector<std::uint32_t>Requests(std::size_t Count,std::size_t Distinct,std::uint64_t Seed)
+{
+    std::mt19937_64 Engine{Seed};
+    std::uniform_real_distribution<double>Uniform{0.0,1.0};
+    std::vector<std::uint32_t>Stream(Count);
+    for(auto&i:Stream)
+    {
+        double u{Uniform(Engine)};
+        i=static_cast<std::uint32_t>(u*u*u*Distinct);
+    };
+    return Stream;
+};
+void Report(const char*Name,double Direct,double Cached,const CacheCounters&Counters,std::size_t Mismatches)
+{
+    double Lookups{static_cast<double>(Counters.Hits+Counters.Misses)};
+    std::cout<<std::setw(16)<<std::left<<Name<<std::right<<std::setw(11)<<1e3*Direct<<std::setw(11)<<1e3*Cached
+        <<std::setw(10)<<100.0*Counters.Hits/Lookups<<std::setw(11)<<Counters.Evictions<<std::setw(8)<<Counters.StaleEvictions
+        <<std::setw(11)<<Mismatches<<"\n";
+};
+int main()
+{
+    std::cout<<std::setprecision(4)<<ThreadCount()<<" threads\n";
+    std::cout<<"Pricer           direct ms  cached ms  hit rate  evictions   stale  mismatches\n";
+
+    //Intraday zero-coupon requests; the curve moves four times, shifting every rate and bumping the version.
+    {
+        const std::size_t Distinct{50000},Count{4000000},Moves{4};
+        std::vector<ZeroCouponStruct>Bonds(Distinct);
+        for(std::size_t i=0;i<Distinct;++i)Bonds[i]={1000.0*(1+i%7),0.02+1e-7*i,0.5+(i%60)*0.5,0.0};
+        auto Stream{Requests(Count,Distinct,3)};
+        ZeroCouponCache Cache{32768};
+        double Direct{0.0},Cached{0.0};
+        std::size_t Mismatches{0};
+        for(std::size_t Move=0;Move<Moves;++Move)
+        {
+            if(Move>0)
+            {
+                for(auto&Bond:Bonds)Bond.InterestRate+=1e-4;
+                Cache.InvalidateCurve();
+            };
+            std::size_t Begin{Count*Move/Moves},End{Count*(Move+1)/Moves};
+            std::vector<double>Plain(End-Begin),Memo(End-Begin);
+            auto Start{std::chrono::steady_clock::now()};
+            ParallelFor(End-Begin,[&](std::size_t b,std::size_t e)
+            {
+                for(std::size_t i=b;i<e;++i)
+                {
+                    ZeroCouponStruct Zero{Bonds[Stream[Begin+i]]};
+                    ZeroCouponBond(Zero);
+                    Plain[i]=Zero.Price;
+                };
+            });
+            Direct+=Seconds(Start);
+            Start=std::chrono::steady_clock::now();
+            ParallelFor(End-Begin,[&](std::size_t b,std::size_t e)
+            {
+                for(std::size_t i=b;i<e;++i)
+                {
+                    ZeroCouponStruct Zero{Bonds[Stream[Begin+i]]};
+                    ZeroCouponBond(Zero,Cache);
+                    Memo[i]=Zero.Price;
+                };
+            });
+            Cached+=Seconds(Start);
+            for(std::size_t i=0;i<Plain.size();++i)Mismatches+=Plain[i]!=Memo[i];
+        };
+        Report("ZeroCouponBond",Direct,Cached,Cache.Counters(),Mismatches);
+    };
+
+    //The same cache in front of a pricer worth caching: a 500-step American lattice.
+    {
+        const std::size_t Distinct{2000},Count{40000};
+        std::vector<OptionStruct>Options(Distinct);
+        for(std::size_t i=0;i<Distinct;++i)Options[i]={100.0,80.0+0.02*i,0.03,0.25+(i%8)*0.25,0.2,i%2?1.0:-1.0,0.0};
+        auto Stream{Requests(Count,Distinct,5)};
+        OptionCache Cache{4096};
+        std::vector<double>Plain(Count),Memo(Count);
+        auto Start{std::chrono::steady_clock::now()};
+        ParallelFor(Count,[&](std::size_t b,std::size_t e)
+        {
+            for(std::size_t i=b;i<e;++i)
+            {
+                OptionStruct Option{Options[Stream[i]]};
+                BinomialAmerican(Option,500);
+                Plain[i]=Option.Price;
+            };
+        });
+        double Direct{Seconds(Start)};
+        Start=std::chrono::steady_clock::now();
+        ParallelFor(Count,[&](std::size_t b,std::size_t e)
+        {
+            for(std::size_t i=b;i<e;++i)
+            {
+                OptionStruct Option{Options[Stream[i]]};
+                Memo[i]=Cache.FindOrPrice({Option.Spot,Option.Strike,Option.InterestRate,Option.YearFraction,Option.Volatility,Option.Theta},
+                    [&]{BinomialAmerican(Option,500);return Option.Price;});
+            };
+        });
+        double Cached{Seconds(Start)};
+        std::size_t Mismatches{0};
+        for(std::size_t i=0;i<Count;++i)Mismatches+=Plain[i]!=Memo[i];
+        Report("American, 500",Direct,Cached,Cache.Counters(),Mismatches);
+    };
+    return 0;
+};
+/*
+Replays skewed streams of repeated pricing requests through the sharded price cache and directly, with
+curve moves invalidating the cache by version, and checks every cached price against a fresh one.
+ZeroCouponBond is a single exp, about the cost of a lookup, so the cache pays off for the lattice pricer.
+
+Build with
+g++ -std=c++20 -O3 -march=native -fopenmp-simd -pthread PriceCache.cc -o PriceCache
+*/
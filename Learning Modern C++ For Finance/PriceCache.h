@@ -0,0 +1,176 @@
+#ifndef PriceCache_H
+#define PriceCache_H
+#include<array>
+#include<vector>
+#include<mutex>
+#include<atomic>
+#include<memory>
+#include<bit>
+#include<cstdint>
+#include<cstddef>
+#include"ZeroCoupnBond.h"
+#include"BlackScholes.h"
+#include"Trace.h"
+
+struct CacheCounters
+{
+    std::size_t Hits{0};
+    std::size_t Misses{0};
+    std::size_t Evictions{0};
+    std::size_t StaleEvictions{0};
+};
+//Memo of prices keyed on the exact bits of N pricing inputs plus the curve version they were priced on.
+//A hash picks a shard (own mutex) and within it a set of Ways entries, searched in full. A new entry takes a
+//free or stale way, otherwise CLOCK within the set: the hand skips ways referenced since it last passed,
+//clearing their bit, and evicts the first unreferenced one. Capacity is therefore fixed, and
+//InvalidateCurve is one atomic increment: entries of older versions can never match again and are the
+//first to be overwritten.
+template<std::size_t N>
+class PriceCache
+{
+public:
+    using Key=std::array<double,N>;
+    static constexpr std::size_t Ways{8};
+    explicit PriceCache(std::size_t Capacity,std::size_t ShardCount=64)
+    {
+        Shards=std::bit_ceil(ShardCount);
+        SetsPerShard=std::bit_ceil(std::max<std::size_t>(1,Capacity/(Shards*Ways)));
+        Storage=std::make_unique<Shard[]>(Shards);
+        for(std::size_t s=0;s<Shards;++s)Storage[s].Sets.resize(SetsPerShard);
+    };
+    std::uint64_t CurveVersion()const{return Version.load(std::memory_order_acquire);};
+    void InvalidateCurve(){Version.fetch_add(1,std::memory_order_acq_rel);};
+    std::size_t Capacity()const{return Shards*SetsPerShard*Ways;};
+    bool Find(const Key&Inputs,double&Price)
+    {
+        std::uint64_t v{CurveVersion()};
+        std::uint64_t h{Hash(Inputs,v)};
+        Shard&s{Storage[h&(Shards-1)]};
+        std::lock_guard<std::mutex>Lock{s.Mutex};
+        Set&Row{s.Sets[(h>>32)&(SetsPerShard-1)]};
+        for(std::size_t w=0;w<Ways;++w)
+        {
+            if(Row.Tags[w]!=h||!(Row.Used>>w&1))continue;
+            const Entry&e{Row.Entries[w]};
+            if(e.Version==v&&e.Inputs==Inputs)
+            {
+                Row.Referenced|=1u<<w;
+                Price=e.Price;
+                ++s.Counters.Hits;
+                return true;
+            };
+        };
+        ++s.Counters.Misses;
+        return false;
+    };
+    void Insert(const Key&Inputs,double Price,std::uint64_t PricedOn)
+    {
+        std::uint64_t h{Hash(Inputs,PricedOn)};
+        Shard&s{Storage[h&(Shards-1)]};
+        std::lock_guard<std::mutex>Lock{s.Mutex};
+        Set&Row{s.Sets[(h>>32)&(SetsPerShard-1)]};
+        std::uint64_t Current{CurveVersion()};
+        std::size_t Victim{Ways};
+        for(std::size_t w=0;w<Ways&&Victim==Ways;++w)
+        {
+            if(!(Row.Used>>w&1))Victim=w;
+            else if(Row.Entries[w].Version!=Current)
+            {
+                Victim=w;
+                ++s.Counters.StaleEvictions;
+            }else if(Row.Tags[w]==h&&Row.Entries[w].Inputs==Inputs)return;
+        };
+        if(Victim==Ways)
+        {
+            while(Row.Referenced>>Row.Hand&1)
+            {
+                Row.Referenced&=~(1u<<Row.Hand);
+                Row.Hand=(Row.Hand+1)%Ways;
+            };
+            Victim=Row.Hand;
+            Row.Hand=(Row.Hand+1)%Ways;
+            ++s.Counters.Evictions;
+        };
+        Row.Tags[Victim]=h;
+        Row.Entries[Victim]={PricedOn,Inputs,Price};
+        Row.Used|=1u<<Victim;
+        Row.Referenced&=~(1u<<Victim);
+    };
+    //Cached price, or Pricer() stored under the version current before it ran, so a curve change during a
+    //slow pricing leaves an entry that is already stale rather than a wrong one.
+    template<typename Pricer>
+    double FindOrPrice(const Key&Inputs,Pricer&&Price)
+    {
+        double Cached;
+        if(Find(Inputs,Cached))
+        {
+            TRACE_COUNT("Price cache hits",1);
+            return Cached;
+        };
+        TRACE_COUNT("Price cache misses",1);
+        std::uint64_t PricedOn{CurveVersion()};
+        double Value{Price()};
+        Insert(Inputs,Value,PricedOn);
+        return Value;
+    };
+    CacheCounters Counters()const
+    {
+        CacheCounters Total{};
+        for(std::size_t s=0;s<Shards;++s)
+        {
+            std::lock_guard<std::mutex>Lock{Storage[s].Mutex};
+            Total.Hits+=Storage[s].Counters.Hits;
+            Total.Misses+=Storage[s].Counters.Misses;
+            Total.Evictions+=Storage[s].Counters.Evictions;
+            Total.StaleEvictions+=Storage[s].Counters.StaleEvictions;
+        };
+        return Total;
+    };
+private:
+    struct Entry
+    {
+        std::uint64_t Version;
+        Key Inputs;
+        double Price;
+    };
+    //The eight hashes fill one cache line and are compared before any entry is touched.
+    struct Set
+    {
+        alignas(64)std::array<std::uint64_t,Ways>Tags{};
+        std::array<Entry,Ways>Entries{};
+        std::uint32_t Used{0};
+        std::uint32_t Referenced{0};
+        std::uint32_t Hand{0};
+    };
+    struct alignas(64)Shard
+    {
+        mutable std::mutex Mutex;
+        std::vector<Set>Sets;
+        CacheCounters Counters;
+    };
+    std::size_t Shards;
+    std::size_t SetsPerShard;
+    std::unique_ptr<Shard[]>Storage;
+    std::atomic<std::uint64_t>Version{0};
+    //Multiply-xorshift over the raw bits of each input and the version.
+    static std::uint64_t Hash(const Key&Inputs,std::uint64_t v)
+    {
+        std::uint64_t h{v*0x9E3779B97F4A7C15ull};
+        for(double x:Inputs)
+        {
+            h^=std::bit_cast<std::uint64_t>(x);
+            h*=0xBF58476D1CE4E5B9ull;
+            h^=h>>31;
+        };
+        h*=0x94D049BB133111EBull;
+        return h^(h>>29);
+    };
+};
+using ZeroCouponCache=PriceCache<3>;
+using OptionCache=PriceCache<6>;
+inline void ZeroCouponBond(ZeroCouponStruct&Zero,ZeroCouponCache&Cache)
+{
+    Zero.Price=Cache.FindOrPrice({Zero.FaceValue,Zero.InterestRate,Zero.YearFraction},[&]{ZeroCouponBond(Zero);return Zero.Price;});
+};
+
+#endif
@@ -0,0 +1,119 @@
+#include"PricingServer.h"
+#include<thread>
+#include<chrono>
+#include<algorithm>
+#include<poll.h>
+std::int64_t Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+};
+int Connect(const std::string&Path)
+{
+    int Fd{socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0)};
+    sockaddr_un Address{};
+    Address.sun_family=AF_UNIX;
+    std::strncpy(Address.sun_path,Path.c_str(),sizeof Address.sun_path-1);
+    while(connect(Fd,reinterpret_cast<sockaddr*>(&Address),sizeof Address)<0)std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    return Fd;
+};
+//One client: keeps Depth single-trade requests in flight and records each round trip. Requests are queued
+//and written only when the socket takes them, so a server that stops reading cannot block the client's
+//reads. A positive ReadDelay (us) makes it a slow reader that sleeps before every read.
+void Client(const std::string&Path,std::size_t Requests,std::size_t Depth,long ReadDelay,std::vector<std::int64_t>&Latency,double&Checksum)
+{
+    int Fd{Connect(Path)};
+    fcntl(Fd,F_SETFL,O_NONBLOCK);
+    std::vector<std::int64_t>Sent(Requests);
+    Latency.resize(Requests);
+    std::size_t Next{0},Done{0};
+    std::vector<char>Outgoing{};
+    auto Send=[&]
+    {
+        PriceRequest Request{Next,static_cast<std::uint32_t>(Next%4==0),0,100.0,100.0,0.01+1e-7*(Next%1000),1.0+Next%30,0.2,1.0};
+        Sent[Next++]=Now();
+        const char*Bytes{reinterpret_cast<const char*>(&Request)};
+        Outgoing.insert(Outgoing.end(),Bytes,Bytes+sizeof Request);
+    };
+    while(Next<std::min(Depth,Requests))Send();
+    PriceResponse Responses[64];
+    std::size_t Buffered{0};
+    while(Done<Requests)
+    {
+        pollfd Wait{Fd,static_cast<short>(POLLIN|(Outgoing.empty()?0:POLLOUT)),0};
+        poll(&Wait,1,-1);
+        if(Wait.revents&POLLOUT)
+        {
+            ssize_t n{send(Fd,Outgoing.data(),Outgoing.size(),MSG_NOSIGNAL)};
+            if(n>0)Outgoing.erase(Outgoing.begin(),Outgoing.begin()+n);
+        };
+        if(!(Wait.revents&POLLIN))continue;
+        if(ReadDelay>0)std::this_thread::sleep_for(std::chrono::microseconds(ReadDelay));
+        ssize_t n{read(Fd,reinterpret_cast<char*>(Responses)+Buffered,sizeof Responses-Buffered)};
+        if(n<0&&errno==EAGAIN)continue;
+        if(n<=0)break;
+        Buffered+=n;
+        std::size_t Whole{Buffered/sizeof(PriceResponse)};
+        std::int64_t Arrived{Now()};
+        for(std::size_t i=0;i<Whole;++i)
+        {
+            Latency[Done++]=Arrived-Sent[Responses[i].Id];
+            Checksum+=Responses[i].Price;
+            if(Next<Requests)Send();
+        };
+        Buffered-=Whole*sizeof(PriceResponse);
+        std::memmove(Responses,reinterpret_cast<char*>(Responses)+Whole*sizeof(PriceResponse),Buffered);
+    };
+    close(Fd);
+};
+void LoadTest(const char*Name,std::size_t MaxBatch,long Window,std::size_t MaxUnsent,std::size_t Clients,std::size_t Requests,std::size_t Depth,long ReadDelay=0,int SocketBuffer=0)
+{
+    const std::string Path{"/tmp/PricingServer.sock"};
+    PricingServer Server{Path};
+    Server.MaxBatch=MaxBatch;
+    Server.Window=Window;
+    Server.MaxUnsent=MaxUnsent;
+    Server.SocketBuffer=SocketBuffer;
+    std::atomic<bool>Stop{false};
+    std::thread Service{[&]{Server.Run(Stop);}};
+    std::vector<std::vector<std::int64_t>>Latency(Clients);
+    std::vector<double>Checksum(Clients,0.0);
+    auto Start{std::chrono::steady_clock::now()};
+    std::vector<std::thread>Threads{};
+    for(std::size_t c=0;c<Clients;++c)Threads.emplace_back([&,c]{Client(Path,Requests,Depth,ReadDelay,Latency[c],Checksum[c]);});
+    for(auto&Thread:Threads)Thread.join();
+    double Seconds{std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count()};
+    Stop=true;
+    Service.join();
+    std::vector<std::int64_t>All{};
+    for(auto&Client:Latency)All.insert(All.end(),Client.begin(),Client.end());
+    auto Percentile=[&](double q)
+    {
+        std::size_t k{std::min(All.size()-1,static_cast<std::size_t>(q*All.size()))};
+        std::nth_element(All.begin(),All.begin()+k,All.end());
+        return All[k]/1000.0;
+    };
+    std::cout<<std::setw(22)<<std::left<<Name<<std::right<<std::setw(12)<<All.size()/Seconds<<std::setw(10)
+        <<static_cast<double>(Server.Stats.Requests)/Server.Stats.Batches<<std::setw(10)<<Percentile(0.5)<<std::setw(10)
+        <<Percentile(0.99)<<std::setw(10)<<Percentile(0.999)<<std::setw(8)<<Server.Stats.Backpressure<<"\n";
+};
+int main()
+{
+    const std::size_t Clients{8},Requests{50000},Depth{8};
+    std::cout<<std::setprecision(4)<<Clients<<" clients x "<<Requests<<" requests, "<<Depth<<" in flight each (latency in us)\n";
+    std::cout<<"Server                 requests/s  avg batch       p50       p99     p99.9  paused\n";
+    LoadTest("one trade per batch",1,0,1<<16,Clients,Requests,Depth);
+    LoadTest("batch 256, 50 us",256,50,1<<16,Clients,Requests,Depth);
+    LoadTest("batch 256, 200 us",256,200,1<<16,Clients,Requests,Depth);
+    //Slow readers with 1024 in flight, 8 KB socket buffers and a 4 KB unsent-response cap: their sockets fill,
+    //the server stops reading their requests until they catch up, and the wait shows up as latency, not memory.
+    LoadTest("slow readers, 4 KB cap",256,50,4096,Clients,Requests/10,1024,1000,8192);
+    return 0;
+};
+/*
+Runs the coroutine pricing server on a Unix socket in one thread and a load generator of several
+pipelining clients against it, with and without micro-batching, and reports throughput, mean batch size,
+round-trip latency percentiles and how often a connection was paused for backpressure.
+
+Build with
+g++ -std=c++20 -O3 -march=native -fopenmp-simd -pthread PricingServer.cc -o PricingServer
+*/
@@ -0,0 +1,355 @@
+#ifndef PricingServer_H
+#define PricingServer_H
+#include<coroutine>
+#include<exception>
+#include<memory>
+#include<vector>
+#include<unordered_map>
+#include<string>
+#include<atomic>
+#include<cstring>
+#include<cstdint>
+#include<cstddef>
+#include<sys/epoll.h>
+#include<sys/socket.h>
+#include<sys/timerfd.h>
+#include<sys/un.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<cerrno>
+#include<system_error>
+#include"ZeroCoupnBond.h"
+#include"BlackScholes.h"
+#include"VectorMath.h"
+#include"Trace.h"
+
+//Wire format, native endian, one fixed-size record per trade. Kind 0 is a zero-coupon bond
+//(FaceValue, InterestRate, YearFraction), kind 1 an OptionStruct.
+struct PriceRequest
+{
+    std::uint64_t Id;
+    std::uint32_t Kind;
+    std::uint32_t Reserved;
+    double FaceValueOrSpot;
+    double Strike;
+    double InterestRate;
+    double YearFraction;
+    double Volatility;
+    double Theta;
+};
+struct PriceResponse
+{
+    std::uint64_t Id;
+    double Price;
+};
+//Coroutine that starts immediately and frees itself when it returns; the event loop owns the suspended frames.
+struct Task
+{
+    struct promise_type
+    {
+        Task get_return_object(){return {};};
+        std::suspend_never initial_suspend()noexcept{return {};};
+        std::suspend_never final_suspend()noexcept{return {};};
+        void return_void(){};
+        void unhandled_exception(){std::terminate();};
+    };
+};
+//Single-threaded epoll loop. Each descriptor has at most one suspended coroutine, woken once (EPOLLONESHOT)
+//when any of the events it asked for is ready. Coroutines still suspended when the loop goes are destroyed
+//with it.
+class EventLoop
+{
+public:
+    EventLoop():Epoll{epoll_create1(EPOLL_CLOEXEC)}
+    {
+        if(Epoll<0)throw std::system_error{errno,std::generic_category(),"epoll_create1"};
+    };
+    ~EventLoop()
+    {
+        for(auto&Entry:Waiting)Entry.second.Handle.destroy();
+        close(Epoll);
+    };
+    EventLoop(const EventLoop&)=delete;
+    EventLoop&operator=(const EventLoop&)=delete;
+    void Wait(int Fd,std::uint32_t Events,std::coroutine_handle<>Handle)
+    {
+        Waiting[Fd]={Handle,0};
+        Arm(Fd,Events);
+    };
+    //Changes what a suspended coroutine is waiting for, e.g. adds EPOLLOUT once it has output queued.
+    void Arm(int Fd,std::uint32_t Events)
+    {
+        epoll_event Event{};
+        Event.events=Events|EPOLLONESHOT;
+        Event.data.fd=Fd;
+        if(epoll_ctl(Epoll,EPOLL_CTL_MOD,Fd,&Event)<0)epoll_ctl(Epoll,EPOLL_CTL_ADD,Fd,&Event);
+    };
+    bool IsWaiting(int Fd)const{return Waiting.count(Fd)!=0;};
+    void Forget(int Fd)
+    {
+        epoll_ctl(Epoll,EPOLL_CTL_DEL,Fd,nullptr);
+        Waiting.erase(Fd);
+    };
+    std::uint32_t Fired(int Fd)const
+    {
+        auto Found{Waiting.find(Fd)};
+        return Found==Waiting.end()?0:Found->second.Fired;
+    };
+    void Run(const std::atomic<bool>&Stop)
+    {
+        epoll_event Events[64];
+        while(!Stop.load(std::memory_order_relaxed))
+        {
+            int Count{epoll_wait(Epoll,Events,64,10)};
+            for(int i=0;i<Count;++i)
+            {
+                auto Found{Waiting.find(Events[i].data.fd)};
+                if(Found==Waiting.end())continue;
+                auto Handle{Found->second.Handle};
+                Found->second.Fired=Events[i].events;
+                Handle.resume();
+            };
+        };
+    };
+private:
+    struct Waiter
+    {
+        std::coroutine_handle<>Handle;
+        std::uint32_t Fired;
+    };
+    int Epoll;
+    std::unordered_map<int,Waiter>Waiting;
+};
+//co_await Ready{Loop,Fd,EPOLLIN} suspends until Fd is readable and returns the events that fired.
+struct Ready
+{
+    EventLoop&Loop;
+    int Fd;
+    std::uint32_t Events;
+    bool await_ready()const{return false;};
+    void await_suspend(std::coroutine_handle<>Handle){Loop.Wait(Fd,Events,Handle);};
+    std::uint32_t await_resume()const{return Loop.Fired(Fd);};
+};
+struct ServerStats
+{
+    std::size_t Requests{0};
+    std::size_t Batches{0};
+    std::size_t Backpressure{0};
+};
+//Pricing service on a Unix stream socket. Requests from all connections are queued into one micro-batch that
+//is priced when it holds MaxBatch trades or Window microseconds after its first trade arrived, whichever is
+//first, so concurrent single-trade callers still hit the column kernels. A connection whose unsent responses
+//exceed MaxUnsent bytes stops being read until its client drains them, which pushes back through the socket
+//buffers to a client that sends faster than it reads.
+class PricingServer
+{
+public:
+    std::size_t MaxBatch{256};
+    long Window{100};
+    std::size_t MaxUnsent{1<<16};
+    //Kernel send buffer for accepted connections, 0 for the system default.
+    int SocketBuffer{0};
+    ServerStats Stats;
+    //Throws std::system_error if the socket or the timer cannot be set up.
+    explicit PricingServer(const std::string&Path):Path{Path}
+    {
+        Listener=socket(AF_UNIX,SOCK_STREAM|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+        if(Listener<0)throw std::system_error{errno,std::generic_category(),"socket"};
+        sockaddr_un Address{};
+        Address.sun_family=AF_UNIX;
+        std::strncpy(Address.sun_path,Path.c_str(),sizeof Address.sun_path-1);
+        unlink(Path.c_str());
+        if(bind(Listener,reinterpret_cast<sockaddr*>(&Address),sizeof Address)<0)Fail("bind "+Path);
+        if(listen(Listener,128)<0)Fail("listen");
+        Timer=timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+        if(Timer<0)Fail("timerfd_create");
+    };
+    ~PricingServer()
+    {
+        close(Listener);
+        close(Timer);
+        unlink(Path.c_str());
+    };
+    PricingServer(const PricingServer&)=delete;
+    PricingServer&operator=(const PricingServer&)=delete;
+    void Run(const std::atomic<bool>&Stop)
+    {
+        Accept();
+        Expire();
+        Loop.Run(Stop);
+    };
+private:
+    //Owns its socket: closed when the last coroutine or batch entry holding the connection lets go.
+    struct Connection
+    {
+        int Fd;
+        bool Open{true};
+        std::vector<char>In{};
+        std::vector<char>Out{};
+        std::size_t Sent{0};
+        explicit Connection(int Fd):Fd{Fd}{};
+        ~Connection(){if(Fd>=0)close(Fd);};
+        Connection(const Connection&)=delete;
+        Connection&operator=(const Connection&)=delete;
+        std::size_t Unsent()const{return Out.size()-Sent;};
+        //Non-blocking write of whatever is queued; false once the peer is gone.
+        bool Flush()
+        {
+            while(Sent<Out.size())
+            {
+                ssize_t n{send(Fd,Out.data()+Sent,Out.size()-Sent,MSG_NOSIGNAL)};
+                if(n>0)Sent+=n;
+                else if(n<0&&errno==EAGAIN)break;
+                else return false;
+            };
+            if(Sent==Out.size())
+            {
+                Out.clear();
+                Sent=0;
+            };
+            return true;
+        };
+    };
+    struct Pending
+    {
+        PriceRequest Request;
+        std::shared_ptr<Connection>Client;
+    };
+    std::string Path;
+    int Listener{-1};
+    int Timer{-1};
+    EventLoop Loop;
+    std::vector<Pending>Batch;
+    std::vector<double>Face,Rate,YearFraction,Price;
+    std::vector<OptionStruct>Options;
+
+    [[noreturn]]void Fail(const std::string&What)
+    {
+        int Error{errno};
+        close(Listener);
+        if(Timer>=0)close(Timer);
+        unlink(Path.c_str());
+        throw std::system_error{Error,std::generic_category(),What};
+    };
+    Task Accept()
+    {
+        for(;;)
+        {
+            co_await Ready{Loop,Listener,EPOLLIN};
+            for(int Fd;(Fd=accept4(Listener,nullptr,nullptr,SOCK_NONBLOCK|SOCK_CLOEXEC))>=0;)
+            {
+                if(SocketBuffer>0)setsockopt(Fd,SOL_SOCKET,SO_SNDBUF,&SocketBuffer,sizeof SocketBuffer);
+                Serve(std::make_shared<Connection>(Fd));
+            };
+        };
+    };
+    Task Serve(std::shared_ptr<Connection>Client)
+    {
+        char Buffer[1<<14];
+        for(;;)
+        {
+            if(Client->Unsent()>MaxUnsent)
+            {
+                ++Stats.Backpressure;
+                co_await Ready{Loop,Client->Fd,EPOLLOUT};
+                if(!Client->Flush())break;
+                continue;
+            };
+            std::uint32_t Events{co_await Ready{Loop,Client->Fd,EPOLLIN|(Client->Unsent()?EPOLLOUT:0u)}};
+            if((Events&EPOLLOUT)&&!Client->Flush())break;
+            if(!(Events&(EPOLLIN|EPOLLHUP|EPOLLERR)))continue;
+            ssize_t n{0};
+            while((n=recv(Client->Fd,Buffer,sizeof Buffer,0))>0)Client->In.insert(Client->In.end(),Buffer,Buffer+n);
+            if(n==0||(n<0&&errno!=EAGAIN))break;
+            std::size_t Whole{Client->In.size()/sizeof(PriceRequest)};
+            for(std::size_t i=0;i<Whole;++i)
+            {
+                PriceRequest Request;
+                std::memcpy(&Request,Client->In.data()+i*sizeof Request,sizeof Request);
+                Enqueue(Request,Client);
+            };
+            Client->In.erase(Client->In.begin(),Client->In.begin()+Whole*sizeof(PriceRequest));
+        };
+        Client->Open=false;
+        Loop.Forget(Client->Fd);
+        close(Client->Fd);
+        Client->Fd=-1;
+    };
+    Task Expire()
+    {
+        for(;;)
+        {
+            co_await Ready{Loop,Timer,EPOLLIN};
+            std::uint64_t Expirations;
+            if(read(Timer,&Expirations,sizeof Expirations)>0)PriceBatch();
+        };
+    };
+    void Enqueue(const PriceRequest&Request,const std::shared_ptr<Connection>&Client)
+    {
+        Batch.push_back({Request,Client});
+        if(Batch.size()>=MaxBatch||Window<=0)PriceBatch();
+        else if(Batch.size()==1)
+        {
+            itimerspec Delay{};
+            Delay.it_value.tv_sec=Window/1000000;
+            Delay.it_value.tv_nsec=Window%1000000*1000;
+            timerfd_settime(Timer,0,&Delay,nullptr);
+        };
+    };
+    //Prices the batch as columns, bonds through one simd loop and options through BlackScholes, then queues
+    //each response on its connection and writes as much as the sockets take.
+    void PriceBatch()
+    {
+        if(Batch.empty())return;
+        TRACE_SCOPE("Server batch");
+        TRACE_VALUE("Server batch size",Batch.size());
+        TRACE_COUNT("Server requests",Batch.size());
+        itimerspec Disarm{};
+        timerfd_settime(Timer,0,&Disarm,nullptr);
+        Face.clear();
+        Rate.clear();
+        YearFraction.clear();
+        Options.clear();
+        for(auto&Entry:Batch)
+        {
+            const PriceRequest&r{Entry.Request};
+            if(r.Kind==0)
+            {
+                Face.push_back(r.FaceValueOrSpot);
+                Rate.push_back(r.InterestRate);
+                YearFraction.push_back(r.YearFraction);
+            }else Options.push_back(OptionStruct{r.FaceValueOrSpot,r.Strike,r.InterestRate,r.YearFraction,r.Volatility,r.Theta,0.0});
+        };
+        std::size_t Bonds{Face.size()};
+        Price.resize(Bonds);
+        const double*__restrict A{Face.data()};
+        const double*__restrict r{Rate.data()};
+        const double*__restrict t{YearFraction.data()};
+        double*__restrict P{Price.data()};
+        #pragma omp simd
+        for(std::size_t i=0;i<Bonds;++i)P[i]=A[i]*ExpSimd(-r[i]*t[i]);
+        for(auto&Option:Options)BlackScholes(Option);
+        std::size_t Bond{0},Option{0};
+        std::vector<Connection*>Touched{};
+        for(auto&Entry:Batch)
+        {
+            PriceResponse Response{Entry.Request.Id,Entry.Request.Kind==0?Price[Bond++]:Options[Option++].Price};
+            Connection&Client{*Entry.Client};
+            if(!Client.Open)continue;
+            if(Client.Out.empty())Touched.push_back(&Client);
+            const char*Bytes{reinterpret_cast<const char*>(&Response)};
+            Client.Out.insert(Client.Out.end(),Bytes,Bytes+sizeof Response);
+        };
+        for(Connection*Client:Touched)
+        {
+            Client->Flush();
+            //Output left over: make sure the suspended reader is also woken when the socket drains.
+            if(Client->Unsent()&&Loop.IsWaiting(Client->Fd))Loop.Arm(Client->Fd,EPOLLIN|EPOLLOUT);
+        };
+        Stats.Requests+=Batch.size();
+        ++Stats.Batches;
+        Batch.clear();
+    };
+};
+
+#endif
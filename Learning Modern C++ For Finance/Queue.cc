@@ -0,0 +1,96 @@
+#include"Queue.h"
+#include"ZeroCoupnBond.h"
+#include<vector>
+#include<chrono>
+#include<memory>
+std::int64_t Now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+};
+//Consumer side: drains ticks in batches, reprices the bond each one moves and records feed-to-price latency.
+template<typename Ring>
+std::vector<std::int64_t>PriceFromQueue(Ring&Queue,std::size_t Ticks,std::vector<ZeroCouponStruct>&Book)
+{
+    std::vector<std::int64_t>Latency{};
+    Latency.reserve(Ticks);
+    MarketTick Batch[64];
+    SpinBackoff Wait{};
+    while(Latency.size()<Ticks)
+    {
+        std::size_t Count{Queue.PopBatch(Batch,64)};
+        if(Count==0)
+        {
+            Wait.Pause();
+            continue;
+        };
+        Wait.Reset();
+        for(std::size_t i=0;i<Count;++i)
+        {
+            ZeroCouponStruct&Bond{Book[Batch[i].Instrument]};
+            Bond.InterestRate=Batch[i].Value;
+            ZeroCouponBond(Bond);
+            Latency.push_back(Now()-Batch[i].Stamp);
+        };
+    };
+    return Latency;
+};
+//Feed side: one tick every Gap ns, stamped just before the push.
+template<typename Ring>
+void Feed(Ring&Queue,std::size_t Ticks,std::size_t Instruments,std::int64_t Gap,std::uint32_t Seed)
+{
+    std::int64_t Next{Now()};
+    for(std::size_t i=0;i<Ticks;++i)
+    {
+        Next+=Gap;
+        while(Now()<Next)std::this_thread::yield();
+        std::uint32_t Instrument{static_cast<std::uint32_t>((i*2654435761u+Seed)%Instruments)};
+        Queue.Push(MarketTick{Instrument,0,0.02+1e-6*(i%1000),Now()});
+    };
+};
+void Report(const char*Name,std::vector<std::int64_t>Latency)
+{
+    auto Percentile=[&](double q)
+    {
+        std::size_t k{std::min(Latency.size()-1,static_cast<std::size_t>(q*Latency.size()))};
+        std::nth_element(Latency.begin(),Latency.begin()+k,Latency.end());
+        return Latency[k];
+    };
+    std::cout<<std::setw(18)<<std::left<<Name<<std::right<<std::setw(10)<<Percentile(0.5)<<std::setw(10)<<Percentile(0.99)
+        <<std::setw(12)<<Percentile(0.999)<<std::setw(12)<<*std::max_element(Latency.begin(),Latency.end())<<"\n";
+};
+int main()
+{
+    const std::size_t Ticks{200000},Instruments{1000};
+    const std::int64_t Gap{2000};
+    std::vector<ZeroCouponStruct>Book(Instruments,ZeroCouponStruct{100.0,0.02,5.0,0.0});
+    std::cout<<Ticks<<" ticks, one every "<<Gap<<" ns per producer, "<<std::thread::hardware_concurrency()<<" hardware threads\n";
+    std::cout<<"Queue                    p50       p99     p99.9         max   (ns)\n";
+    {
+        auto Queue{std::make_unique<SpscRing<MarketTick,4096>>()};
+        std::thread Producer{[&]{Feed(*Queue,Ticks,Instruments,Gap,0);}};
+        auto Latency{PriceFromQueue(*Queue,Ticks,Book)};
+        Producer.join();
+        Report("SPSC",std::move(Latency));
+    };
+    {
+        auto Queue{std::make_unique<MpscRing<MarketTick,4096>>()};
+        std::thread First{[&]{Feed(*Queue,Ticks/2,Instruments,2*Gap,1);}};
+        std::thread Second{[&]{Feed(*Queue,Ticks/2,Instruments,2*Gap,7);}};
+        auto Latency{PriceFromQueue(*Queue,Ticks,Book)};
+        First.join();
+        Second.join();
+        Report("MPSC, 2 producers",std::move(Latency));
+    };
+    double Sum{0.0};
+    for(auto&Bond:Book)Sum+=Bond.Price;
+    std::cout<<"Book value after the last tick : "<<Sum<<"\n";
+    return 0;
+};
+/*
+Feeds zero-rate ticks from producer threads through the lock-free rings in Queue.h to a consumer that
+reprices the affected ZeroCouponStruct on every tick, and reports feed-to-price latency percentiles.
+With fewer cores than threads the waits fall through to yield and the tail reflects the scheduler.
+
+Build with
+g++ -std=c++20 -O3 -march=native -pthread Queue.cc -o Queue
+*/
@@ -0,0 +1,190 @@
+#ifndef Queue_H
+#define Queue_H
+#include<atomic>
+#include<thread>
+#include<cstddef>
+#include<cstdint>
+#include<array>
+#include<algorithm>
+#include<cstring>
+#include<type_traits>
+#if defined(__x86_64__)||defined(__i386__)
+#include<immintrin.h>
+#endif
+
+//Fixed rather than std::hardware_destructive_interference_size, which GCC warns is not ABI-stable.
+constexpr std::size_t CacheLine{64};
+
+//One market-data update: a new zero rate or spot for an instrument, stamped by the feed in steady_clock ns.
+struct MarketTick
+{
+    std::uint32_t Instrument;
+    std::uint32_t Field;
+    double Value;
+    std::int64_t Stamp;
+};
+//Spin with a pause instruction, then yield once the other side is clearly not about to make progress.
+struct SpinBackoff
+{
+    unsigned Spins{0};
+    unsigned SpinLimit{256};
+    void Pause()
+    {
+        if(Spins++<SpinLimit)
+        {
+#if defined(__x86_64__)||defined(__i386__)
+            _mm_pause();
+#endif
+        }else std::this_thread::yield();
+    };
+    void Reset(){Spins=0;};
+};
+//Single-producer single-consumer ring. Head and Tail sit on their own cache lines and each side keeps a
+//private copy of the other's index, refreshed only when the ring looks full (producer) or empty (consumer),
+//so in steady state neither side reads the other's line. Capacity must be a power of two.
+template<typename T,std::size_t Capacity>
+class SpscRing
+{
+    static_assert((Capacity&(Capacity-1))==0,"Capacity must be a power of two");
+public:
+    bool TryPush(const T&Item)
+    {
+        std::size_t t{Tail.load(std::memory_order_relaxed)};
+        if(t-HeadCache==Capacity)
+        {
+            HeadCache=Head.load(std::memory_order_acquire);
+            if(t-HeadCache==Capacity)return false;
+        };
+        Slots[t&(Capacity-1)]=Item;
+        Tail.store(t+1,std::memory_order_release);
+        return true;
+    };
+    void Push(const T&Item)
+    {
+        SpinBackoff Wait{};
+        while(!TryPush(Item))Wait.Pause();
+    };
+    //Moves up to Max items into Out with one acquire and one release; returns how many.
+    std::size_t PopBatch(T*Out,std::size_t Max)
+    {
+        std::size_t h{Head.load(std::memory_order_relaxed)};
+        if(TailCache==h)
+        {
+            TailCache=Tail.load(std::memory_order_acquire);
+            if(TailCache==h)return 0;
+        };
+        std::size_t Count{std::min(Max,TailCache-h)};
+        for(std::size_t i=0;i<Count;++i)Out[i]=Slots[(h+i)&(Capacity-1)];
+        Head.store(h+Count,std::memory_order_release);
+        return Count;
+    };
+    bool TryPop(T&Item){return PopBatch(&Item,1)==1;};
+private:
+    alignas(CacheLine)std::atomic<std::size_t>Head{0};
+    std::size_t TailCache{0};
+    alignas(CacheLine)std::atomic<std::size_t>Tail{0};
+    std::size_t HeadCache{0};
+    alignas(CacheLine)std::array<T,Capacity>Slots{};
+};
+//Bounded multi-producer single-consumer ring (Vyukov): producers claim a position with a CAS on Tail and
+//publish through the slot's sequence number, so the consumer never waits on a lock, only on a slot that
+//has been claimed but not yet written.
+template<typename T,std::size_t Capacity>
+class MpscRing
+{
+    static_assert((Capacity&(Capacity-1))==0,"Capacity must be a power of two");
+    struct alignas(CacheLine)Slot
+    {
+        std::atomic<std::size_t>Sequence;
+        T Item;
+    };
+public:
+    MpscRing()
+    {
+        for(std::size_t i=0;i<Capacity;++i)Slots[i].Sequence.store(i,std::memory_order_relaxed);
+    };
+    bool TryPush(const T&Item)
+    {
+        std::size_t t{Tail.load(std::memory_order_relaxed)};
+        for(;;)
+        {
+            Slot&s{Slots[t&(Capacity-1)]};
+            std::size_t Sequence{s.Sequence.load(std::memory_order_acquire)};
+            auto Difference{static_cast<std::ptrdiff_t>(Sequence)-static_cast<std::ptrdiff_t>(t)};
+            if(Difference==0)
+            {
+                if(Tail.compare_exchange_weak(t,t+1,std::memory_order_relaxed))
+                {
+                    s.Item=Item;
+                    s.Sequence.store(t+1,std::memory_order_release);
+                    return true;
+                };
+            }else if(Difference<0)return false;
+            else t=Tail.load(std::memory_order_relaxed);
+        };
+    };
+    void Push(const T&Item)
+    {
+        SpinBackoff Wait{};
+        while(!TryPush(Item))Wait.Pause();
+    };
+    std::size_t PopBatch(T*Out,std::size_t Max)
+    {
+        std::size_t Count{0};
+        while(Count<Max)
+        {
+            Slot&s{Slots[Head&(Capacity-1)]};
+            if(s.Sequence.load(std::memory_order_acquire)!=Head+1)break;
+            Out[Count++]=s.Item;
+            s.Sequence.store(Head+Capacity,std::memory_order_release);
+            ++Head;
+        };
+        return Count;
+    };
+    bool TryPop(T&Item){return PopBatch(&Item,1)==1;};
+private:
+    alignas(CacheLine)std::atomic<std::size_t>Tail{0};
+    alignas(CacheLine)std::size_t Head{0};
+    std::array<Slot,Capacity>Slots;
+};
+
+//Latest value of a trivially copyable T, written by one thread and polled by any number of readers without
+//locks (a seqlock). The writer makes Sequence odd, stores the words, then makes it even again; a reader copies
+//the words between two loads of Sequence and keeps the copy only if both loads saw the same even value. The
+//words are relaxed atomics so a copy torn by a concurrent write is detected rather than undefined.
+template<typename T>
+class SeqlockCell
+{
+    static_assert(std::is_trivially_copyable_v<T>,"SeqlockCell holds trivially copyable values");
+    static constexpr std::size_t Words{(sizeof(T)+7)/8};
+public:
+    void Publish(const T&Value)
+    {
+        std::uint64_t Buffer[Words]{};
+        std::memcpy(Buffer,&Value,sizeof(T));
+        std::uint64_t s{Sequence.load(std::memory_order_relaxed)};
+        Sequence.store(s+1,std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for(std::size_t w=0;w<Words;++w)Data[w].store(Buffer[w],std::memory_order_relaxed);
+        Sequence.store(s+2,std::memory_order_release);
+    };
+    //False if nothing has been published yet or a write was in progress.
+    bool TryRead(T&Value)const
+    {
+        std::uint64_t s{Sequence.load(std::memory_order_acquire)};
+        if(s==0||(s&1))return false;
+        std::uint64_t Buffer[Words];
+        for(std::size_t w=0;w<Words;++w)Buffer[w]=Data[w].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(Sequence.load(std::memory_order_relaxed)!=s)return false;
+        std::memcpy(&Value,Buffer,sizeof(T));
+        return true;
+    };
+    //Number of values published so far; readers compare it with the last one they saw before copying.
+    std::uint64_t Version()const{return Sequence.load(std::memory_order_acquire)/2;};
+private:
+    alignas(CacheLine)std::atomic<std::uint64_t>Sequence{0};
+    std::atomic<std::uint64_t>Data[Words]{};
+};
+
+#endif
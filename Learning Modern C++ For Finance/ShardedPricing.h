@@ -0,0 +1,338 @@
+#ifndef ShardedPricing_H
+#define ShardedPricing_H
+#include<atomic>
+#include<string>
+#include<vector>
+#include<cstdint>
+#include<cstddef>
+#include<ctime>
+#include<cerrno>
+#include<system_error>
+#include<stdexcept>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<sys/wait.h>
+#include<sys/syscall.h>
+#include<linux/futex.h>
+#include<signal.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include"ZeroCoupnBond.h"
+#include"VectorMath.h"
+#include"Summation.h"
+
+//Process-shared futex on a 32-bit atomic in a shared mapping (std::atomic::wait uses private futexes).
+static_assert(sizeof(std::atomic<std::uint32_t>)==sizeof(std::uint32_t)&&std::atomic<std::uint32_t>::is_always_lock_free);
+inline void FutexWait(std::atomic<std::uint32_t>&Word,std::uint32_t Expected,long TimeoutNs)
+{
+    timespec Timeout{TimeoutNs/1000000000,TimeoutNs%1000000000};
+    syscall(SYS_futex,reinterpret_cast<std::uint32_t*>(&Word),FUTEX_WAIT,Expected,&Timeout,nullptr,0);
+};
+inline void FutexWake(std::atomic<std::uint32_t>&Word)
+{
+    syscall(SYS_futex,reinterpret_cast<std::uint32_t*>(&Word),FUTEX_WAKE,INT32_MAX,nullptr,nullptr,0);
+};
+
+//Start of one shard's shared-memory segment. The coordinator writes the first line and the worker the
+//second, so they never share a cache line; the columns follow, each on its own 64-byte boundary.
+struct ShardHeader
+{
+    //Coordinator side: a job is posted by storing Shift and then bumping Request.
+    alignas(64) std::atomic<std::uint32_t>Request;
+    std::atomic<std::uint32_t>Stop;
+    std::uint64_t Capacity;
+    std::uint64_t Count;
+    double Shift;
+    //Worker side: Done is set to the Request it has finished, after the block sums.
+    alignas(64) std::atomic<std::uint32_t>Done;
+    std::atomic<std::uint32_t>Starts;
+};
+//Columnar view of a mapped segment: trade id, the three bond inputs and the price written by the worker,
+//then the worker's compensated sum of each SumBlock of the book it holds, in the order it holds them.
+struct ShardColumns
+{
+    ShardHeader*Header;
+    std::uint64_t*Id;
+    double*FaceValue;
+    double*InterestRate;
+    double*YearFraction;
+    double*Price;
+    NeumaierAccumulator*BlockSum;
+};
+inline std::size_t ShardColumnBytes(std::size_t Capacity){return (Capacity*8+63)/64*64;};
+//A shard holds whole blocks, but the book's last block may be short, hence one more.
+inline std::size_t ShardBlocks(std::size_t Capacity){return Capacity/SumBlock+1;};
+inline std::size_t ShardBytes(std::size_t Capacity){return sizeof(ShardHeader)+5*ShardColumnBytes(Capacity)+ShardBlocks(Capacity)*sizeof(NeumaierAccumulator);};
+inline ShardColumns ShardView(void*Base)
+{
+    ShardHeader*Header{static_cast<ShardHeader*>(Base)};
+    char*Column{static_cast<char*>(Base)+sizeof(ShardHeader)};
+    std::size_t Stride{ShardColumnBytes(Header->Capacity)};
+    return {Header,reinterpret_cast<std::uint64_t*>(Column),reinterpret_cast<double*>(Column+Stride),reinterpret_cast<double*>(Column+2*Stride),
+        reinterpret_cast<double*>(Column+3*Stride),reinterpret_cast<double*>(Column+4*Stride),reinterpret_cast<NeumaierAccumulator*>(Column+5*Stride)};
+};
+//Maps an existing segment by name, as a restarted worker does; nullptr if it is not there.
+inline void*MapShard(const std::string&Name,std::size_t&Bytes)
+{
+    int Fd{shm_open(Name.c_str(),O_RDWR,0)};
+    if(Fd<0)return nullptr;
+    struct stat Status{};
+    fstat(Fd,&Status);
+    Bytes=static_cast<std::size_t>(Status.st_size);
+    void*Base{mmap(nullptr,Bytes,PROT_READ|PROT_WRITE,MAP_SHARED,Fd,0)};
+    close(Fd);
+    return Base==MAP_FAILED?nullptr:Base;
+};
+//Worker main loop: needs only the segment name, so it can equally be exec'd on its own. Everything it
+//prices lives in the segment, so a restarted worker picks up the book and any unfinished job where the
+//previous one left off. Prices are written in place, and each of the shard's blocks is summed exactly as
+//CompensatedSum sums that block of the whole book.
+inline void RunShardWorker(const std::string&Name)
+{
+    std::size_t Bytes;
+    void*Base{MapShard(Name,Bytes)};
+    if(!Base)return;
+    ShardColumns Shard{ShardView(Base)};
+    ShardHeader&Header{*Shard.Header};
+    Header.Starts.fetch_add(1,std::memory_order_relaxed);
+    for(;;)
+    {
+        std::uint32_t Request{Header.Request.load(std::memory_order_acquire)};
+        if(Header.Stop.load(std::memory_order_acquire))break;
+        if(Request==Header.Done.load(std::memory_order_relaxed))
+        {
+            FutexWait(Header.Request,Request,100000000);
+            continue;
+        };
+        const std::size_t Count{Header.Count};
+        const double Shift{Header.Shift};
+        const double*Face{Shard.FaceValue},*Rate{Shard.InterestRate},*Years{Shard.YearFraction};
+        double*Price{Shard.Price};
+        #pragma omp simd
+        for(std::size_t i=0;i<Count;++i)Price[i]=Face[i]*ExpSimd(-(Rate[i]+Shift)*Years[i]);
+        //Rows are in book order and blocks are whole, so every SumBlock rows (fewer for the book's last block)
+        //are one block of the book.
+        auto ValueOf{[&](std::size_t i){return Price[i];}};
+        for(std::size_t Begin=0,b=0;Begin<Count;Begin+=SumBlock,++b)Shard.BlockSum[b]=SumOneBlock<true>(Begin,std::min(Count,Begin+SumBlock),ValueOf);
+        Header.Done.store(Request,std::memory_order_release);
+        FutexWake(Header.Done);
+    };
+    munmap(Base,Bytes);
+};
+
+//Coordinator for a zero-coupon book sharded over Workers local processes by a hash of the trade id's block
+//(id/SumBlock), so each shard holds whole blocks of the book. Each shard is a POSIX shared-memory segment
+//holding its trades as columns; Load writes them there once, and a revaluation only posts a rate shift and
+//collects one compensated sum per block, so no trade data crosses a process boundary after loading. The
+//blocks are folded in book order with the tree of Summation.h, so the book value has the same bits as
+//CompensatedSum over the prices in book order, for any worker count. A worker that dies is detected while
+//waiting and restarted on the same segment.
+class ShardedPricer
+{
+public:
+    std::size_t Restarts{0};
+    //Throws std::invalid_argument for no workers, std::system_error if a segment cannot be created or mapped
+    //or a worker cannot be started.
+    ShardedPricer(const std::string&Prefix,unsigned Workers,std::size_t Capacity):Capacity{Capacity}
+    {
+        if(Workers==0)throw std::invalid_argument{"ShardedPricer: no workers"};
+        for(unsigned s=0;s<Workers;++s)
+        {
+            Shard Segment{Prefix+"-shard"+std::to_string(s),nullptr,ShardBytes(Capacity),0,{},0};
+            shm_unlink(Segment.Name.c_str());
+            int Fd{shm_open(Segment.Name.c_str(),O_CREAT|O_EXCL|O_RDWR,0600)};
+            if(Fd<0)Fail("shm_open "+Segment.Name,errno);
+            if(ftruncate(Fd,static_cast<off_t>(Segment.Bytes))<0)
+            {
+                int Error{errno};
+                close(Fd);
+                shm_unlink(Segment.Name.c_str());
+                Fail("ftruncate "+Segment.Name,Error);
+            };
+            Segment.Base=mmap(nullptr,Segment.Bytes,PROT_READ|PROT_WRITE,MAP_SHARED,Fd,0);
+            int Error{errno};
+            close(Fd);
+            if(Segment.Base==MAP_FAILED)
+            {
+                shm_unlink(Segment.Name.c_str());
+                Fail("mmap "+Segment.Name,Error);
+            };
+            //The mapping comes back zeroed, which is a valid idle header.
+            ShardHeader*Header{static_cast<ShardHeader*>(Segment.Base)};
+            Header->Capacity=Capacity;
+            Segment.View=ShardView(Segment.Base);
+            Shards.push_back(Segment);
+        };
+        try
+        {
+            for(auto&Segment:Shards)Spawn(Segment);
+        }
+        catch(const std::system_error&)
+        {
+            StopWorkers();
+            Release();
+            throw;
+        };
+    };
+    ~ShardedPricer()
+    {
+        StopWorkers();
+        Release();
+    };
+    ShardedPricer(const ShardedPricer&)=delete;
+    ShardedPricer&operator=(const ShardedPricer&)=delete;
+    //Shard of the trades with ids in [Block*SumBlock,(Block+1)*SumBlock).
+    static std::size_t ShardOf(std::uint64_t Block,std::size_t Shards)
+    {
+        //splitmix64 finaliser, so consecutive blocks spread evenly.
+        Block+=0x9E3779B97F4A7C15ull;
+        Block=(Block^(Block>>30))*0xBF58476D1CE4E5B9ull;
+        Block=(Block^(Block>>27))*0x94D049BB133111EBull;
+        return static_cast<std::size_t>((Block^(Block>>31))%Shards);
+    };
+    //Writes the book straight into the shard columns; trade ids are positions in Book. Returns false, with
+    //every shard left empty, if a shard would overflow its capacity.
+    bool Load(const std::vector<ZeroCouponStruct>&Book)
+    {
+        Clear();
+        for(std::size_t i=0;i<Book.size();++i)
+        {
+            Shard&Segment{Shards[ShardOf(i/SumBlock,Shards.size())]};
+            ShardColumns&View{Segment.View};
+            std::uint64_t Row{View.Header->Count};
+            if(Row>=Capacity)
+            {
+                Clear();
+                return false;
+            };
+            View.Header->Count=Row+1;
+            if(i%SumBlock==0)Owner.push_back({static_cast<std::uint32_t>(&Segment-Shards.data()),static_cast<std::uint32_t>(Segment.Blocks++)});
+            View.Id[Row]=i;
+            View.FaceValue[Row]=Book[i].FaceValue;
+            View.InterestRate[Row]=Book[i].InterestRate;
+            View.YearFraction[Row]=Book[i].YearFraction;
+        };
+        Parts.resize(Owner.size());
+        return true;
+    };
+    //Book value under a parallel rate shift: posts the job to every shard, then folds the block sums in book
+    //order once all have finished.
+    double PresentValue(double Shift=0.0)
+    {
+        for(auto&Segment:Shards)
+        {
+            ShardHeader&Header{*Segment.View.Header};
+            Header.Shift=Shift;
+            Header.Request.fetch_add(1,std::memory_order_release);
+            FutexWake(Header.Request);
+        };
+        for(auto&Segment:Shards)
+        {
+            ShardHeader&Header{*Segment.View.Header};
+            std::uint32_t Request{Header.Request.load(std::memory_order_relaxed)};
+            for(;;)
+            {
+                std::uint32_t Done{Header.Done.load(std::memory_order_acquire)};
+                if(Done==Request)break;
+                FutexWait(Header.Done,Done,10000000);
+                if(!Alive(Segment))
+                {
+                    ++Restarts;
+                    Spawn(Segment);
+                };
+            };
+        };
+        for(std::size_t b=0;b<Owner.size();++b)Parts[b]=Shards[Owner[b].Shard].View.BlockSum[Owner[b].Block];
+        return FoldBlocks<true>(Parts);
+    };
+    //Prices from the last revaluation, gathered back into book order.
+    void Prices(std::vector<double>&Out)const
+    {
+        for(const auto&Segment:Shards)
+        {
+            const ShardColumns&View{Segment.View};
+            for(std::uint64_t Row=0;Row<View.Header->Count;++Row)Out[View.Id[Row]]=View.Price[Row];
+        };
+    };
+    std::size_t Workers()const{return Shards.size();};
+    pid_t WorkerPid(std::size_t s)const{return Shards[s].Pid;};
+    std::uint32_t WorkerStarts(std::size_t s)const{return Shards[s].View.Header->Starts.load();};
+private:
+    struct Shard
+    {
+        std::string Name;
+        void*Base;
+        std::size_t Bytes;
+        pid_t Pid;
+        ShardColumns View;
+        std::size_t Blocks;
+    };
+    //Where block b of the book is: its shard and its place among that shard's blocks.
+    struct BlockOwner
+    {
+        std::uint32_t Shard;
+        std::uint32_t Block;
+    };
+    std::size_t Capacity;
+    std::vector<Shard>Shards{};
+    std::vector<BlockOwner>Owner{};
+    std::vector<NeumaierAccumulator>Parts{};
+    void Clear()
+    {
+        for(auto&Segment:Shards)
+        {
+            Segment.View.Header->Count=0;
+            Segment.Blocks=0;
+        };
+        Owner.clear();
+        Parts.clear();
+    };
+    void Release()
+    {
+        for(auto&Segment:Shards)
+        {
+            munmap(Segment.Base,Segment.Bytes);
+            shm_unlink(Segment.Name.c_str());
+        };
+    };
+    //Constructor failure: releases the segments made so far and throws.
+    [[noreturn]]void Fail(const std::string&What,int Error)
+    {
+        Release();
+        throw std::system_error{Error,std::generic_category(),What};
+    };
+    //Starts the shard's worker; throws std::system_error, leaving the shard without one (Pid 0), if fork fails.
+    void Spawn(Shard&Segment)
+    {
+        Segment.Pid=0;
+        pid_t Pid{fork()};
+        if(Pid<0)throw std::system_error{errno,std::generic_category(),"fork worker for "+Segment.Name};
+        if(Pid==0)
+        {
+            RunShardWorker(Segment.Name);
+            _exit(0);
+        };
+        Segment.Pid=Pid;
+    };
+    //A shard without a worker counts as dead, so the next job starts one.
+    bool Alive(Shard&Segment)
+    {
+        return Segment.Pid>0&&waitpid(Segment.Pid,nullptr,WNOHANG)==0;
+    };
+    void StopWorkers()
+    {
+        for(auto&Segment:Shards)
+        {
+            Segment.View.Header->Stop.store(1,std::memory_order_release);
+            Segment.View.Header->Request.fetch_add(1,std::memory_order_release);
+            FutexWake(Segment.View.Header->Request);
+        };
+        for(auto&Segment:Shards)
+        {
+            if(Segment.Pid>0)waitpid(Segment.Pid,nullptr,0);
+            Segment.Pid=0;
+        };
+    };
+};
+
+#endif
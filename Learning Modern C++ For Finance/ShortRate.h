@@ -0,0 +1,417 @@
+#ifndef ShortRate_H
+#define ShortRate_H
+#include<cmath>
+#include<vector>
+#include<array>
+#include<algorithm>
+#include<limits>
+#include<cstdint>
+#include<cstddef>
+#include"BlackScholes.h"
+#include"VectorMath.h"
+#include"NelderMead.h"
+
+//Vasicek short rate: dr=Kappa(LongRunRate-r)dt+Volatility dW, starting from Rate.
+struct VasicekStruct
+{
+    double Rate;
+    double Kappa;
+    double LongRunRate;
+    double Volatility;
+};
+//Zero-coupon bond P(t,t+Tau)=A(Tau)exp(-B(Tau)r).
+inline double VasicekB(const VasicekStruct&Model,double Tau)
+{
+    return (1.0-std::exp(-Model.Kappa*Tau))/Model.Kappa;
+};
+inline double VasicekA(const VasicekStruct&Model,double Tau)
+{
+    double B{VasicekB(Model,Tau)};
+    double s2{Model.Volatility*Model.Volatility};
+    return std::exp((Model.LongRunRate-0.5*s2/(Model.Kappa*Model.Kappa))*(B-Tau)-0.25*s2*B*B/Model.Kappa);
+};
+inline double VasicekZero(const VasicekStruct&Model,double Tau,double r)
+{
+    return VasicekA(Model,Tau)*std::exp(-VasicekB(Model,Tau)*r);
+};
+//Volatility of ln P(T,S)/P(T,T) seen from t, i.e. the Black total volatility of an option expiring at T on
+//the bond maturing at S.
+inline double VasicekBondOptionVolatility(const VasicekStruct&Model,double t,double T,double S)
+{
+    return Model.Volatility*VasicekB(Model,S-T)*std::sqrt((1.0-std::exp(-2.0*Model.Kappa*(T-t)))/(2.0*Model.Kappa));
+};
+//Jamshidian: option at t, expiring at T, on the zero-coupon bond maturing at S, given the discount
+//factors P(t,T) and P(t,S). Theta +1 call, -1 put.
+inline double VasicekBondOption(double ZeroExpiry,double ZeroMaturity,double Strike,double TotalVolatility,double Theta)
+{
+    return ZeroExpiry*BlackPrice(ZeroMaturity/ZeroExpiry,Strike,TotalVolatility,Theta);
+};
+//Exact transition over dt: r_{t+dt}=r e^{-Kappa dt}+LongRunRate(1-e^{-Kappa dt})+StepVolatility Z.
+inline double VasicekStepVolatility(const VasicekStruct&Model,double dt)
+{
+    return Model.Volatility*std::sqrt((1.0-std::exp(-2.0*Model.Kappa*dt))/(2.0*Model.Kappa));
+};
+
+//Initial curve: continuously compounded zero rates at increasing Times, linear in between, flat outside.
+struct ZeroCurve
+{
+    std::vector<double>Times;
+    std::vector<double>Rates;
+    double Rate(double t)const
+    {
+        if(t<=Times.front())return Rates.front();
+        if(t>=Times.back())return Rates.back();
+        std::size_t i{static_cast<std::size_t>(std::upper_bound(Times.begin(),Times.end(),t)-Times.begin())};
+        return Rates[i-1]+(Rates[i]-Rates[i-1])*(t-Times[i-1])/(Times[i]-Times[i-1]);
+    };
+    double Discount(double t)const{return std::exp(-Rate(t)*t);};
+    //Instantaneous forward f(0,t)=d(t z(t))/dt=z+t z'.
+    double Forward(double t)const
+    {
+        if(t<=Times.front()||t>=Times.back())return Rate(t);
+        std::size_t i{static_cast<std::size_t>(std::upper_bound(Times.begin(),Times.end(),t)-Times.begin())};
+        return Rate(t)+t*(Rates[i]-Rates[i-1])/(Times[i]-Times[i-1]);
+    };
+};
+//Hull-White short rate: dr=(Theta(t)-Kappa r)dt+Volatility dW, with Theta(t) fitted to a ZeroCurve.
+struct HullWhiteStruct
+{
+    double Kappa;
+    double Volatility;
+};
+//P(t,T)=A(t,T)exp(-B(t,T)r(t)), with ln A=ln(P(0,T)/P(0,t))+B f(0,t)-Volatility^2(1-e^{-2 Kappa t})B^2/(4 Kappa).
+inline double HullWhiteB(const HullWhiteStruct&Model,double Tau)
+{
+    return (1.0-std::exp(-Model.Kappa*Tau))/Model.Kappa;
+};
+inline double HullWhiteLogA(const HullWhiteStruct&Model,const ZeroCurve&Curve,double t,double T)
+{
+    double B{HullWhiteB(Model,T-t)};
+    double s2{Model.Volatility*Model.Volatility};
+    return std::log(Curve.Discount(T)/Curve.Discount(t))+B*Curve.Forward(t)-0.25*s2*(1.0-std::exp(-2.0*Model.Kappa*t))*B*B/Model.Kappa;
+};
+inline double HullWhiteZero(const HullWhiteStruct&Model,const ZeroCurve&Curve,double t,double T,double r)
+{
+    return std::exp(HullWhiteLogA(Model,Curve,t,T)-HullWhiteB(Model,T-t)*r);
+};
+//Closed-form zero-coupon prices at one date for a batch of maturities: ln A and B are set once, so each
+//short rate, path or scenario then costs one vectorised exp per bond, Price=Face exp(LogA-B r).
+struct ZeroCouponFactors
+{
+    std::vector<double>LogA;
+    std::vector<double>B;
+    void Price(double r,const double*Face,double*Out)const
+    {
+        const double*__restrict a{LogA.data()},*__restrict b{B.data()};
+        #pragma omp simd
+        for(std::size_t i=0;i<LogA.size();++i)Out[i]=Face[i]*ExpSimd(a[i]-b[i]*r);
+    };
+};
+//Bonds maturing at or before t get A=1, B=0.
+inline ZeroCouponFactors VasicekFactors(const VasicekStruct&Model,double t,const double*Maturity,std::size_t Count)
+{
+    ZeroCouponFactors Factors{std::vector<double>(Count),std::vector<double>(Count)};
+    for(std::size_t i=0;i<Count;++i)
+    {
+        double Tau{std::max(0.0,Maturity[i]-t)};
+        Factors.LogA[i]=std::log(VasicekA(Model,Tau));
+        Factors.B[i]=VasicekB(Model,Tau);
+    };
+    return Factors;
+};
+inline ZeroCouponFactors HullWhiteFactors(const HullWhiteStruct&Model,const ZeroCurve&Curve,double t,const double*Maturity,std::size_t Count)
+{
+    ZeroCouponFactors Factors{std::vector<double>(Count),std::vector<double>(Count)};
+    for(std::size_t i=0;i<Count;++i)
+    {
+        double T{std::max(t,Maturity[i])};
+        Factors.LogA[i]=HullWhiteLogA(Model,Curve,t,T);
+        Factors.B[i]=HullWhiteB(Model,T-t);
+    };
+    return Factors;
+};
+
+//European swaption: enter at Expiry into a swap paying or receiving Strike every 1/Frequency until
+//Expiry+Tenor, unit notional; Price is its market value, used only by calibration.
+struct SwaptionQuote
+{
+    double Expiry;
+    double Tenor;
+    double Frequency;
+    double Strike;
+    double Price;
+};
+//A quote's curve data, which does not depend on the model: fixed leg times, cash flows (Strike/Frequency,
+//plus 1 at the end) and discount factors, and P(0,Expiry) and f(0,Expiry).
+struct SwaptionSchedule
+{
+    double Expiry;
+    double ZeroExpiry;
+    double ForwardExpiry;
+    std::vector<double>Pay;
+    std::vector<double>Cash;
+    std::vector<double>Zero;
+};
+inline SwaptionSchedule MakeSwaptionSchedule(const ZeroCurve&Curve,const SwaptionQuote&Quote)
+{
+    SwaptionSchedule Schedule{Quote.Expiry,Curve.Discount(Quote.Expiry),Curve.Forward(Quote.Expiry),{},{},{}};
+    int Payments{static_cast<int>(std::lround(Quote.Tenor*Quote.Frequency))};
+    for(int k=1;k<=Payments;++k)
+    {
+        double t{Quote.Expiry+k/Quote.Frequency};
+        Schedule.Pay.push_back(t);
+        Schedule.Cash.push_back(Quote.Strike/Quote.Frequency+(k==Payments?1.0:0.0));
+        Schedule.Zero.push_back(Curve.Discount(t));
+    };
+    return Schedule;
+};
+//Bachelier (normal volatility) price of a payer (Theta +1) or receiver (-1) swaption, the usual market quote.
+inline double BachelierSwaption(const ZeroCurve&Curve,const SwaptionQuote&Quote,double NormalVolatility,double Theta)
+{
+    SwaptionSchedule Schedule{MakeSwaptionSchedule(Curve,Quote)};
+    double Annuity{0.0};
+    for(double Zero:Schedule.Zero)Annuity+=Zero/Quote.Frequency;
+    double Forward{(Schedule.ZeroExpiry-Schedule.Zero.back())/Annuity};
+    double Deviation{NormalVolatility*std::sqrt(Quote.Expiry)};
+    double d{Theta*(Forward-Quote.Strike)/Deviation};
+    return Annuity*(Theta*(Forward-Quote.Strike)*NormalCdf(d)+Deviation*NormalPdf(d));
+};
+//Hull-White swaption by Jamshidian: a payer is a put and a receiver a call, struck at par, on the bond paying
+//Cash. Find the rate r* at expiry where that bond is worth par, then sum options on each zero-coupon bond
+//struck at its price under r*. Theta +1 payer, -1 receiver.
+inline double HullWhiteSwaption(const HullWhiteStruct&Model,const SwaptionSchedule&Schedule,double Theta)
+{
+    const std::size_t n{Schedule.Pay.size()};
+    const double T{Schedule.Expiry},s2{Model.Volatility*Model.Volatility};
+    const double Spread{0.25*s2*(1.0-std::exp(-2.0*Model.Kappa*T))/Model.Kappa};
+    std::vector<double>LogA(n),B(n);
+    for(std::size_t i=0;i<n;++i)
+    {
+        B[i]=HullWhiteB(Model,Schedule.Pay[i]-T);
+        LogA[i]=std::log(Schedule.Zero[i]/Schedule.ZeroExpiry)+B[i]*Schedule.ForwardExpiry-Spread*B[i]*B[i];
+    };
+    //Newton on the bond value, decreasing and convex in r.
+    double r{Schedule.ForwardExpiry};
+    for(int Iteration=0;Iteration<50;++Iteration)
+    {
+        double Value{-1.0},Slope{0.0};
+        for(std::size_t i=0;i<n;++i)
+        {
+            double v{Schedule.Cash[i]*std::exp(LogA[i]-B[i]*r)};
+            Value+=v;
+            Slope-=B[i]*v;
+        };
+        double Step{Value/Slope};
+        r-=Step;
+        if(std::abs(Step)<1e-14)break;
+    };
+    const double Spread2{std::sqrt((1.0-std::exp(-2.0*Model.Kappa*T))/(2.0*Model.Kappa))};
+    double Price{0.0};
+    for(std::size_t i=0;i<n;++i)
+    {
+        double Strike{std::exp(LogA[i]-B[i]*r)};
+        Price+=Schedule.Cash[i]*VasicekBondOption(Schedule.ZeroExpiry,Schedule.Zero[i],Strike,Model.Volatility*B[i]*Spread2,-Theta);
+    };
+    return Price;
+};
+inline double HullWhiteSwaption(const HullWhiteStruct&Model,const ZeroCurve&Curve,const SwaptionQuote&Quote,double Theta)
+{
+    return HullWhiteSwaption(Model,MakeSwaptionSchedule(Curve,Quote),Theta);
+};
+//Fits Kappa and Volatility to payer swaption prices by least squares on relative errors, over log-parameters
+//so both stay positive. Schedules are built once, so an evaluation is a Newton solve and a few Black
+//formulas per quote. Start is the previous fit when there is one; Error is left with the RMS relative error.
+inline HullWhiteStruct CalibrateHullWhite(const ZeroCurve&Curve,const std::vector<SwaptionQuote>&Quotes,HullWhiteStruct Start,double&Error,bool Warm=false)
+{
+    std::vector<SwaptionSchedule>Schedules{};
+    for(const auto&Quote:Quotes)Schedules.push_back(MakeSwaptionSchedule(Curve,Quote));
+    auto Objective=[&](const std::array<double,2>&x)
+    {
+        HullWhiteStruct Model{std::exp(x[0]),std::exp(x[1])};
+        double Sum{0.0};
+        for(std::size_t q=0;q<Quotes.size();++q)
+        {
+            double e{HullWhiteSwaption(Model,Schedules[q],1.0)/Quotes[q].Price-1.0};
+            Sum+=e*e;
+        };
+        return Sum;
+    };
+    double Value;
+    std::array<double,2>x{NelderMead(Objective,std::array<double,2>{std::log(Start.Kappa),std::log(Start.Volatility)},Warm?0.05:0.5,Warm?150:500,1e-14,Value)};
+    Error=std::sqrt(Value/Quotes.size());
+    return {std::exp(x[0]),std::exp(x[1])};
+};
+
+//Coupon bond callable by the issuer at CallPrice (per unit face) on each coupon date from FirstCall to
+//LastCall, excluding Maturity: FirstCall==LastCall is a European call, LastCall>=Maturity a Bermudan one.
+//Coupons at rate Coupon, Frequency times a year, accrue from Issue; Frequency 0 is a zero-coupon bond.
+//Times are years from today and FirstCall beyond Maturity means not callable.
+struct CallableBondStruct
+{
+    double FaceValue;
+    double Coupon;
+    double Frequency;
+    double Issue;
+    double Maturity;
+    double FirstCall;
+    double LastCall;
+    double CallPrice;
+    double Price;
+};
+//Recombining trinomial tree (Hull-White 1994) for x=r-Alpha(t), dx=-Kappa x dt+Volatility dW, on Steps
+//steps of dt=Horizon/Steps. Alpha is fitted level by level by forward induction so the tree reprices the
+//curve's zero-coupon bonds; Vasicek is the same tree fitted to Vasicek's own curve. Branching depends only on
+//the node index j, so the geometry is the probabilities and middle successor per j and one Alpha per level,
+//O(Steps+Width) however long the tree. Price() rolls a whole book back in one sweep over two levels laid out
+//[node][bond]: each node's probabilities and discount are loaded once and applied to every bond in a
+//vectorised loop, with coupons and issuer calls applied at the levels where they fall.
+class ShortRateTree
+{
+public:
+    int Steps;
+    int Top;
+    double dt;
+    double dx;
+    std::vector<double>Alpha{};
+    template<typename Function>
+    ShortRateTree(double Kappa,double Volatility,double Horizon,int Steps,Function&&Discount):Steps{Steps},dt{Horizon/Steps}
+    {
+        double M{std::exp(-Kappa*dt)-1.0};
+        dx=std::sqrt(3.0*Volatility*Volatility*(1.0-std::exp(-2.0*Kappa*dt))/(2.0*Kappa));
+        Top=static_cast<int>(std::ceil(-0.1835/M));
+        const int Width{2*Top+1};
+        for(auto*Column:{&Up,&Middle,&Down,&NodeDiscount})Column->resize(Width);
+        Next.resize(Width);
+        for(int j=-Top;j<=Top;++j)
+        {
+            double jM{j*M},jM2{jM*jM};
+            int k{j==Top?j-1:(j==-Top?j+1:j)};
+            double u,m,d;
+            if(j==Top)
+            {
+                u=7.0/6.0+0.5*(jM2+3.0*jM);
+                m=-1.0/3.0-jM2-2.0*jM;
+                d=1.0/6.0+0.5*(jM2+jM);
+            }else if(j==-Top)
+            {
+                u=1.0/6.0+0.5*(jM2-jM);
+                m=-1.0/3.0-jM2+2.0*jM;
+                d=7.0/6.0+0.5*(jM2-3.0*jM);
+            }else
+            {
+                u=1.0/6.0+0.5*(jM2+jM);
+                m=2.0/3.0-jM2;
+                d=1.0/6.0+0.5*(jM2-jM);
+            };
+            Up[j+Top]=u;
+            Middle[j+Top]=m;
+            Down[j+Top]=d;
+            Next[j+Top]=k;
+            NodeDiscount[j+Top]=std::exp(-j*dx*dt);
+        };
+        //Q holds the Arrow-Debreu prices of the current level's nodes.
+        Alpha.resize(Steps);
+        LevelDiscount.resize(Steps);
+        std::vector<double>Q(Width,0.0),QNext(Width,0.0);
+        Q[Top]=1.0;
+        for(int i=0;i<Steps;++i)
+        {
+            int m{std::min(i,Top)};
+            double Sum{0.0};
+            for(int j=-m;j<=m;++j)Sum+=Q[j+Top]*NodeDiscount[j+Top];
+            Alpha[i]=(std::log(Sum)-std::log(Discount((i+1)*dt)))/dt;
+            LevelDiscount[i]=std::exp(-Alpha[i]*dt);
+            std::fill(QNext.begin(),QNext.end(),0.0);
+            for(int j=-m;j<=m;++j)
+            {
+                double v{Q[j+Top]*LevelDiscount[i]*NodeDiscount[j+Top]};
+                int k{Next[j+Top]+Top};
+                QNext[k+1]+=Up[j+Top]*v;
+                QNext[k]+=Middle[j+Top]*v;
+                QNext[k-1]+=Down[j+Top]*v;
+            };
+            std::swap(Q,QNext);
+        };
+    };
+    double Rate(int Level,int j)const{return Alpha[Level]+j*dx;};
+    //Prices every bond at today's node; cash flows after the horizon are dropped, so Horizon should cover the
+    //longest maturity. Dates are rounded to the nearest level.
+    void Price(std::vector<CallableBondStruct>&Bonds)
+    {
+        const std::size_t n{Bonds.size()};
+        const int Width{2*Top+1};
+        Events.clear();
+        for(std::uint32_t b=0;b<n;++b)Schedule(Bonds[b],b);
+        std::sort(Events.begin(),Events.end(),[](const Event&a,const Event&b){return a.Level>b.Level;});
+        Value.assign(static_cast<std::size_t>(Width)*n,0.0);
+        Scratch.assign(static_cast<std::size_t>(Width)*n,0.0);
+        std::size_t e{0};
+        for(int i=Steps;i>=0;--i)
+        {
+            int m{std::min(i,Top)};
+            if(i<Steps)
+            {
+                for(int j=-m;j<=m;++j)
+                {
+                    int k{Next[j+Top]+Top};
+                    double Discount{LevelDiscount[i]*NodeDiscount[j+Top]};
+                    double u{Discount*Up[j+Top]},c{Discount*Middle[j+Top]},d{Discount*Down[j+Top]};
+                    const double*__restrict Above{Value.data()+(k+1)*n},*__restrict Same{Value.data()+k*n},*__restrict Below{Value.data()+(k-1)*n};
+                    double*__restrict Out{Scratch.data()+(j+Top)*n};
+                    #pragma omp simd
+                    for(std::size_t b=0;b<n;++b)Out[b]=u*Above[b]+c*Same[b]+d*Below[b];
+                };
+                std::swap(Value,Scratch);
+            };
+            for(;e<Events.size()&&Events[e].Level==i;++e)
+            {
+                const Event&Flow{Events[e]};
+                for(int j=-m;j<=m;++j)
+                {
+                    double&v{Value[(j+Top)*n+Flow.Bond]};
+                    v=std::min(v,Flow.Call)+Flow.Cash;
+                };
+            };
+        };
+        for(std::uint32_t b=0;b<n;++b)Bonds[b].Price=Value[Top*n+b];
+    };
+private:
+    struct Event
+    {
+        int Level;
+        std::uint32_t Bond;
+        double Cash;
+        double Call;
+    };
+    std::vector<double>Up{},Middle{},Down{},NodeDiscount{},LevelDiscount{};
+    std::vector<int>Next{};
+    std::vector<Event>Events{};
+    std::vector<double>Value{},Scratch{};
+    //The bond's schedule dates, latest first, each with the cash paid there and the call price if callable.
+    void Schedule(const CallableBondStruct&Bond,std::uint32_t b)
+    {
+        const double Never{std::numeric_limits<double>::infinity()};
+        if(Bond.Frequency<=0.0)
+        {
+            if(Bond.Maturity>0.0)Add(Bond.Maturity,b,Bond.FaceValue,Never);
+            return;
+        };
+        const double Period{1.0/Bond.Frequency};
+        for(int k=0;;++k)
+        {
+            double t{Bond.Maturity-k*Period};
+            if(t<Bond.Issue-1e-9||t<0.0)break;
+            double Cash{t>Bond.Issue+1e-9?Bond.FaceValue*Bond.Coupon*Period:0.0};
+            if(k==0)Cash+=Bond.FaceValue;
+            bool Callable{k>0&&t>=Bond.FirstCall-1e-9&&t<=Bond.LastCall+1e-9};
+            Add(t,b,Cash,Callable?Bond.FaceValue*Bond.CallPrice:Never);
+        };
+    };
+    void Add(double t,std::uint32_t b,double Cash,double Call)
+    {
+        int Level{static_cast<int>(std::lround(t/dt))};
+        if(Level<=Steps)Events.push_back({Level,b,Cash,Call});
+    };
+};
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef Summation_H
+#define Summation_H
+#include<vector>
+#include<cmath>
+#include<cstddef>
+#include"Parallel.h"
+
+//Summation for book-level aggregates. A plain running sum loses digits on long books and, once split over
+//threads, gives a result that depends on the split. Here the order of every addition is a function of the
+//element count alone: values are cut into fixed blocks of SumBlock, each block is summed in SumLanes
+//independent lanes (element i of a block always goes to lane i%SumLanes) that are folded in a fixed tree,
+//and the block results are folded in a fixed pairwise tree. Threads only decide who computes which block,
+//and the lanes are explicit, so the bits are the same for any thread count and any SIMD width.
+//Everything here relies on IEEE evaluation: do not build it with -ffast-math, which would reassociate the
+//lanes and delete the compensation terms.
+constexpr std::size_t SumLanes{8};
+constexpr std::size_t SumBlock{4096};
+
+//Neumaier's improvement of Kahan summation: the rounding error of each addition is recovered exactly and
+//carried, whichever of the running sum and the addend is larger.
+struct NeumaierAccumulator
+{
+    double Sum{0.0};
+    double Carry{0.0};
+    void Add(double x)
+    {
+        double t{Sum+x};
+        Carry+=std::abs(Sum)>=std::abs(x)?(Sum-t)+x:(x-t)+Sum;
+        Sum=t;
+    };
+    void Add(const NeumaierAccumulator&Other)
+    {
+        Add(Other.Sum);
+        Carry+=Other.Carry;
+    };
+    double Total()const{return Sum+Carry;};
+};
+//Classic Kahan summation, sequential; loses the carry when an addend is larger than the running sum.
+inline double KahanSum(const double*Values,std::size_t Count)
+{
+    double Sum{0.0},Compensation{0.0};
+    for(std::size_t i=0;i<Count;++i)
+    {
+        double y{Values[i]-Compensation};
+        double t{Sum+y};
+        Compensation=(t-Sum)-y;
+        Sum=t;
+    };
+    return Sum;
+};
+inline double NeumaierSum(const double*Values,std::size_t Count)
+{
+    NeumaierAccumulator Sum{};
+    for(std::size_t i=0;i<Count;++i)Sum.Add(Values[i]);
+    return Sum.Total();
+};
+//One lane step; compensated lanes carry their rounding errors as well (Neumaier, written with a select so it
+//vectorises).
+template<bool Compensated>
+inline void AddToLane(double&Sum,double&Carry,double x)
+{
+    double t{Sum+x};
+    if constexpr(Compensated)Carry+=std::abs(Sum)>=std::abs(x)?(Sum-t)+x:(x-t)+Sum;
+    Sum=t;
+};
+//Folds SumLanes lanes 0+4,1+5,2+6,3+7, then 0+2,1+3, then 0+1.
+template<bool Compensated>
+NeumaierAccumulator FoldLanes(const double*Sum,const double*Carry)
+{
+    NeumaierAccumulator Lanes[SumLanes]{};
+    for(std::size_t Lane=0;Lane<SumLanes;++Lane)Lanes[Lane]={Sum[Lane],Carry[Lane]};
+    for(std::size_t Width=SumLanes/2;Width>0;Width/=2)
+    {
+        for(std::size_t Lane=0;Lane<Width;++Lane)
+        {
+            if constexpr(Compensated)Lanes[Lane].Add(Lanes[Lane+Width]);
+            else Lanes[Lane].Sum+=Lanes[Lane+Width].Sum;
+        };
+    };
+    return Lanes[0];
+};
+//One block [Begin,End) in SumLanes lanes, element Begin+i in lane i%SumLanes.
+template<bool Compensated,typename Function>
+NeumaierAccumulator SumOneBlock(std::size_t Begin,std::size_t End,Function&ValueOf)
+{
+    double Sum[SumLanes]{},Carry[SumLanes]{};
+    std::size_t i{Begin};
+    for(;i+SumLanes<=End;i+=SumLanes)
+    {
+        #pragma omp simd
+        for(std::size_t Lane=0;Lane<SumLanes;++Lane)AddToLane<Compensated>(Sum[Lane],Carry[Lane],ValueOf(i+Lane));
+    };
+    for(std::size_t Lane=0;i+Lane<End;++Lane)AddToLane<Compensated>(Sum[Lane],Carry[Lane],ValueOf(i+Lane));
+    return FoldLanes<Compensated>(Sum,Carry);
+};
+//Folds the block results, block b holding elements [b*SumBlock,(b+1)*SumBlock), pairwise: the tree depends on
+//the block count only. Overwrites Parts. For callers that sum the blocks elsewhere, e.g. in other processes.
+template<bool Compensated>
+double FoldBlocks(std::vector<NeumaierAccumulator>&Parts)
+{
+    for(std::size_t n=Parts.size();n>1;n=(n+1)/2)
+    {
+        for(std::size_t k=0;k<n/2;++k)
+        {
+            NeumaierAccumulator Left{Parts[2*k]};
+            if constexpr(Compensated)Left.Add(Parts[2*k+1]);
+            else Left.Sum+=Parts[2*k+1].Sum;
+            Parts[k]=Left;
+        };
+        if(n%2)Parts[n/2]=Parts[n-1];
+    };
+    return Parts.empty()?0.0:Parts[0].Total();
+};
+template<bool Compensated,typename Function>
+double ReproducibleSum(std::size_t Count,Function&&ValueOf,unsigned Threads)
+{
+    std::size_t Blocks{(Count+SumBlock-1)/SumBlock};
+    std::vector<NeumaierAccumulator>Parts(Blocks);
+    ParallelFor(Blocks,[&](std::size_t Begin,std::size_t End)
+    {
+        for(std::size_t b=Begin;b<End;++b)Parts[b]=SumOneBlock<Compensated>(b*SumBlock,std::min(Count,(b+1)*SumBlock),ValueOf);
+    },Threads,1);
+    return FoldBlocks<Compensated>(Parts);
+};
+//Fixed-tree pairwise sum of ValueOf(0..Count-1): error grows with log(Count), about the speed of a naive sum.
+template<typename Function>
+double PairwiseSum(std::size_t Count,Function&&ValueOf,unsigned Threads=ThreadCount())
+{
+    return ReproducibleSum<false>(Count,ValueOf,Threads);
+};
+inline double PairwiseSum(const std::vector<double>&Values,unsigned Threads=ThreadCount())
+{
+    return PairwiseSum(Values.size(),[p=Values.data()](std::size_t i){return p[i];},Threads);
+};
+//Same tree with Neumaier lanes and nodes: the result is (nearly always) the correctly rounded sum.
+template<typename Function>
+double CompensatedSum(std::size_t Count,Function&&ValueOf,unsigned Threads=ThreadCount())
+{
+    return ReproducibleSum<true>(Count,ValueOf,Threads);
+};
+inline double CompensatedSum(const std::vector<double>&Values,unsigned Threads=ThreadCount())
+{
+    return CompensatedSum(Values.size(),[p=Values.data()](std::size_t i){return p[i];},Threads);
+};
+
+#endif
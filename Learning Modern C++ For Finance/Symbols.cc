@@ -0,0 +1,119 @@
+#include"Symbols.h"
+#include"Journal.h"
+#include<unordered_map>
+#include<chrono>
+#include<random>
+#include<fstream>
+double Seconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+};
+template<typename Function>
+double Time(Function&&Body)
+{
+    auto Start{std::chrono::steady_clock::now()};
+    Body();
+    return Seconds(Start);
+};
+//Resident set size in MB, from /proc/self/statm.
+double ResidentMB()
+{
+    std::ifstream Statm{"/proc/self/statm"};
+    std::size_t Total,Resident;
+    Statm>>Total>>Resident;
+    return Resident*static_cast<double>(sysconf(_SC_PAGESIZE))/1048576.0;
+};
+//ISIN: country code, nine alphanumerics and the Luhn check digit over the letters expanded to 10..35.
+std::string MakeIsin(const char*Country,std::uint64_t Serial)
+{
+    static const char Alphabet[]{"0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+    std::string Isin{Country};
+    //A multiplier prime to 36 permutes the 36^9 codes, so serials map to distinct, scattered codes.
+    std::uint64_t Code{(Serial*1000000007ull+12345)%101559956668416ull};
+    char Body[9];
+    for(int i=8;i>=0;--i,Code/=36)Body[i]=Alphabet[Code%36];
+    Isin.append(Body,9);
+    std::string Digits{};
+    for(char c:Isin)Digits+=std::isdigit(static_cast<unsigned char>(c))?std::string(1,c):std::to_string(c-'A'+10);
+    int Sum{0};
+    for(std::size_t i=0;i<Digits.size();++i)
+    {
+        int d{Digits[Digits.size()-1-i]-'0'};
+        if(i%2==0)d=d*2>9?d*2-9:d*2;
+        Sum+=d;
+    };
+    Isin+=static_cast<char>('0'+(10-Sum%10)%10);
+    return Isin;
+};
+int main()
+{
+    const std::size_t Count{10000000},Misses{1000000};
+    const char*Countries[]{"US","GB","DE","FR","JP","XS","CH","NL"};
+    std::vector<std::string>Keys(Count),Absent(Misses);
+    for(std::size_t i=0;i<Count;++i)Keys[i]=MakeIsin(Countries[i%8],i/8);
+    for(std::size_t i=0;i<Misses;++i)Absent[i]=MakeIsin("ZZ",i);
+    std::vector<std::uint32_t>Order(Count);
+    for(std::uint32_t i=0;i<Count;++i)Order[i]=i;
+    std::shuffle(Order.begin(),Order.end(),std::mt19937_64{46});
+    std::cout<<std::setprecision(4)<<Count<<" ISINs (e.g. "<<Keys[0]<<", "<<Keys[1]<<"), lookups in random order, "<<Misses<<" misses\n";
+    std::cout<<"                               insert ns   hit ns   batched hit ns   miss ns   resident MB\n";
+
+    std::uint64_t Check[2]{0,0};
+    double Base{ResidentMB()};
+    {
+        SymbolTable Symbols{};
+        double Insert{Time([&]{for(const auto&Key:Keys)Symbols.Intern(Key);})};
+        double Memory{ResidentMB()-Base};
+        double Hit{Time([&]{for(std::uint32_t i:Order)Check[0]+=Symbols.Find(Keys[i]);})};
+        double Miss{Time([&]{for(const auto&Key:Absent)Check[0]+=Symbols.Find(Key)==NoSymbol;})};
+        //The same lookups through the batched Find, as a bulk load would issue them.
+        std::vector<std::string_view>Shuffled(Count);
+        for(std::size_t i=0;i<Count;++i)Shuffled[i]=Keys[Order[i]];
+        std::vector<std::uint32_t>Ids(Count);
+        double Batched{Time([&]{Symbols.Find(Shuffled.data(),Count,Ids.data());})};
+        bool Agree{true};
+        for(std::size_t i=0;i<Count;++i)Agree=Agree&&Ids[i]==Order[i];
+        std::cout<<"SymbolTable (flat, SSE2)  "<<std::setw(14)<<1e9*Insert/Count<<std::setw(9)<<1e9*Hit/Count<<std::setw(17)<<1e9*Batched/Count
+            <<std::setw(10)<<1e9*Miss/Misses<<std::setw(14)<<Memory<<(Agree?"":"  batched ids WRONG")<<"\n";
+
+        //Ids are dense and in first-seen order, so a book loaded in feed order has row == id and ISIN-keyed
+        //updates resolve to a row with one lookup.
+        PricedBook Book{};
+        std::vector<ZeroCouponStruct>Bonds(Count);
+        std::mt19937_64 Engine{46};
+        std::uniform_real_distribution<double>Rate{0.0,0.08},Years{0.1,30.0};
+        for(auto&Bond:Bonds)Bond={1e6,Rate(Engine),Years(Engine),0.0};
+        Book.Load(Bonds);
+        double Update{Time([&]
+        {
+            for(std::size_t u=0;u<1000000;++u)
+            {
+                const std::string&Isin{Keys[Order[u]]};
+                std::uint32_t Row{Symbols.Find(Isin)};
+                Book.Apply({Book.Sequence+1,JournalKind::Trade,0,Row,Book.FaceValue[Row],Book.InterestRate[Row]+1e-4,Book.YearFraction[Row]});
+            };
+        })};
+        std::cout<<"ISIN-keyed rate update resolved and repriced through the id: "<<1e3*Update<<" ns each\n";
+    };
+    Base=ResidentMB();
+    {
+        std::unordered_map<std::string,std::uint32_t>Map{};
+        double Insert{Time([&]{for(std::uint32_t i=0;i<Count;++i)Map.emplace(Keys[i],i);})};
+        double Memory{ResidentMB()-Base};
+        double Hit{Time([&]{for(std::uint32_t i:Order)Check[1]+=Map.find(Keys[i])->second;})};
+        double Miss{Time([&]{for(const auto&Key:Absent)Check[1]+=Map.find(Key)==Map.end();})};
+        std::cout<<"std::unordered_map        "<<std::setw(14)<<1e9*Insert/Count<<std::setw(9)<<1e9*Hit/Count<<std::setw(17)<<"-"
+            <<std::setw(10)<<1e9*Miss/Misses<<std::setw(14)<<Memory<<"\n";
+    };
+    std::cout<<"same ids from both: "<<(Check[0]==Check[1]?"yes":"NO")<<"\n";
+    return 0;
+};
+/*
+Interns ten million generated ISINs into dense ids with the flat SIMD-probed symbol table and with
+std::unordered_map<std::string,std::uint32_t>, and compares insert, hit and miss cost and resident memory;
+then resolves ISIN-keyed rate updates to rows of an id-keyed PricedBook. The unordered_map figure for
+memory is measured after the symbol table has been freed, so part of it may reuse that space.
+
+Build with
+g++ -std=c++20 -O3 -march=native -fopenmp-simd -fno-math-errno -pthread Symbols.cc -o Symbols
+*/
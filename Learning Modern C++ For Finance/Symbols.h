@@ -0,0 +1,201 @@
+#ifndef Symbols_H
+#define Symbols_H
+#include<vector>
+#include<string>
+#include<string_view>
+#include<algorithm>
+#include<cstring>
+#include<cstdint>
+#include<cstddef>
+#if defined(__SSE2__)
+#include<immintrin.h>
+#endif
+
+//Id for a symbol that is not in the table.
+constexpr std::uint32_t NoSymbol{0xFFFFFFFFu};
+//64-bit hash of an identifier, eight bytes at a time; ISINs (12 characters) and CUSIPs (9) take two words.
+inline std::uint64_t HashSymbol(std::string_view Text)
+{
+    std::uint64_t h{0x9E3779B97F4A7C15ull^Text.size()};
+    std::size_t i{0};
+    for(;i+8<=Text.size();i+=8)
+    {
+        std::uint64_t w;
+        std::memcpy(&w,Text.data()+i,8);
+        h=(h^w)*0xBF58476D1CE4E5B9ull;
+        h^=h>>31;
+    };
+    if(i<Text.size())
+    {
+        std::uint64_t w{0};
+        std::memcpy(&w,Text.data()+i,Text.size()-i);
+        h=(h^w)*0xBF58476D1CE4E5B9ull;
+        h^=h>>31;
+    };
+    h*=0x94D049BB133111EBull;
+    return h^(h>>29);
+};
+//One 16-slot group of control bytes: bit i of the result is set where byte i equals Byte.
+inline std::uint32_t MatchControl(const std::int8_t*Group,std::int8_t Byte)
+{
+#if defined(__SSE2__)
+    __m128i Control{_mm_loadu_si128(reinterpret_cast<const __m128i*>(Group))};
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(Control,_mm_set1_epi8(Byte))));
+#else
+    std::uint32_t Mask{0};
+    for(int i=0;i<16;++i)Mask|=static_cast<std::uint32_t>(Group[i]==Byte)<<i;
+    return Mask;
+#endif
+};
+
+//Interns instrument identifiers (ISIN, CUSIP, tickers) into dense 32-bit ids, assigned 0,1,2,... in order of
+//first appearance, so books, caches and ticks can key on the id and index plain vectors with it. Names are
+//stored back to back in one buffer. The index is a Swiss-table style open-addressing map: slots come in
+//groups of 16 with one control byte each, empty or the low 7 bits of the hash; a probe compares a whole
+//group's control bytes against those 7 bits with one SSE2 compare and only then looks at candidate slots.
+//A slot carries the first 16 bytes of its name, which covers ISINs and CUSIPs whole, so a hit costs the
+//control group and the slot and never the name buffer. Groups are probed triangularly and the table doubles
+//at 7/8 full. There is no erase: ids stay valid for the life of the table.
+class SymbolTable
+{
+public:
+    SymbolTable(){Rehash(16);};
+    void Reserve(std::size_t Count)
+    {
+        Offset.reserve(Count+1);
+        std::size_t Slots{16};
+        while(Slots*7/8<Count)Slots*=2;
+        if(Slots>Control.size())Rehash(Slots);
+    };
+    //Id of Name, adding it if it is new.
+    std::uint32_t Intern(std::string_view Name)
+    {
+        std::uint64_t h{HashSymbol(Name)};
+        if(Size()+1>Control.size()*7/8)Rehash(2*Control.size());
+        //One probe: a miss stops at the first group with an empty slot, which is where the name goes.
+        std::size_t Free{0};
+        std::uint32_t Id{Find(Name,h,&Free)};
+        if(Id!=NoSymbol)return Id;
+        Id=static_cast<std::uint32_t>(Size());
+        Text.insert(Text.end(),Name.begin(),Name.end());
+        Offset.push_back(static_cast<std::uint64_t>(Text.size()));
+        Fill(Free,Id,h);
+        return Id;
+    };
+    //Id of Name, or NoSymbol.
+    std::uint32_t Find(std::string_view Name)const{return Find(Name,HashSymbol(Name));};
+    //Ids of Count names, for bulk loads. Names go through in blocks of 16: hash all and prefetch their home
+    //groups' control bytes, then match the control bytes and prefetch each first candidate slot, then probe.
+    //The cache misses of a block overlap instead of following one another.
+    void Find(const std::string_view*Names,std::size_t Count,std::uint32_t*Out)const
+    {
+        constexpr std::size_t Block{16};
+        std::uint64_t h[Block];
+        for(std::size_t Begin=0;Begin<Count;Begin+=Block)
+        {
+            std::size_t n{std::min(Block,Count-Begin)};
+            for(std::size_t i=0;i<n;++i)
+            {
+                h[i]=HashSymbol(Names[Begin+i]);
+                __builtin_prefetch(Control.data()+16*((h[i]>>7)&GroupMask));
+            };
+            for(std::size_t i=0;i<n;++i)
+            {
+                std::size_t Group{(h[i]>>7)&GroupMask};
+                std::uint32_t Match{MatchControl(Control.data()+16*Group,Tag(h[i]))};
+                if(Match)__builtin_prefetch(Slot.data()+16*Group+__builtin_ctz(Match));
+            };
+            for(std::size_t i=0;i<n;++i)Out[Begin+i]=Find(Names[Begin+i],h[i]);
+        };
+    };
+    std::string_view Name(std::uint32_t Id)const{return {Text.data()+Offset[Id],static_cast<std::size_t>(Offset[Id+1]-Offset[Id])};};
+    std::size_t Size()const{return Offset.size()-1;};
+    //Bytes held by names, offsets, control bytes and slots.
+    std::size_t Bytes()const
+    {
+        return Text.capacity()+Offset.capacity()*sizeof(std::uint64_t)+Control.size()*(1+sizeof(Entry));
+    };
+private:
+    static constexpr std::int8_t Empty{-128};
+    static constexpr std::size_t Inline{16};
+    struct Entry
+    {
+        char Key[Inline];
+        std::uint32_t Id;
+        std::uint32_t Length;
+    };
+    std::vector<char>Text{};
+    std::vector<std::uint64_t>Offset{0};
+    std::vector<std::int8_t>Control{};
+    std::vector<Entry>Slot{};
+    std::size_t GroupMask{0};
+    static std::int8_t Tag(std::uint64_t h){return static_cast<std::int8_t>(h&0x7F);};
+    std::uint32_t Find(std::string_view Name,std::uint64_t h,std::size_t*Free=nullptr)const
+    {
+        const std::int8_t t{Tag(h)};
+        std::size_t Group{(h>>7)&GroupMask};
+        for(std::size_t Step=1;;++Step)
+        {
+            const std::int8_t*Bytes{Control.data()+16*Group};
+            for(std::uint32_t Match{MatchControl(Bytes,t)};Match;Match&=Match-1)
+            {
+                const Entry&e{Slot[16*Group+static_cast<std::size_t>(__builtin_ctz(Match))]};
+                if(e.Length!=Name.size()||std::memcmp(e.Key,Name.data(),std::min(Name.size(),Inline))!=0)continue;
+                if(Name.size()<=Inline||this->Name(e.Id)==Name)return e.Id;
+            };
+            if(std::uint32_t Empties{MatchControl(Bytes,Empty)})
+            {
+                if(Free)*Free=16*Group+static_cast<std::size_t>(__builtin_ctz(Empties));
+                return NoSymbol;
+            };
+            Group=(Group+Step)&GroupMask;
+        };
+    };
+    void Fill(std::size_t s,std::uint32_t Id,std::uint64_t h)
+    {
+        std::string_view Key{Name(Id)};
+        Entry&e{Slot[s]};
+        std::memcpy(e.Key,Key.data(),std::min(Key.size(),Inline));
+        e.Id=Id;
+        e.Length=static_cast<std::uint32_t>(Key.size());
+        Control[s]=Tag(h);
+    };
+    //Puts Id in the first empty slot on its probe sequence.
+    void Place(std::uint32_t Id,std::uint64_t h)
+    {
+        std::size_t Group{(h>>7)&GroupMask};
+        for(std::size_t Step=1;;++Step)
+        {
+            std::uint32_t Free{MatchControl(Control.data()+16*Group,Empty)};
+            if(Free)
+            {
+                Fill(16*Group+static_cast<std::size_t>(__builtin_ctz(Free)),Id,h);
+                return;
+            };
+            Group=(Group+Step)&GroupMask;
+        };
+    };
+    void Rehash(std::size_t Slots)
+    {
+        Control.assign(Slots,Empty);
+        Slot.assign(Slots,Entry{});
+        GroupMask=Slots/16-1;
+        //Names are read in id order, i.e. straight through the buffer, and placed in blocks of 16 whose home
+        //groups are prefetched first, as in the batched Find.
+        std::uint64_t h[16];
+        for(std::uint32_t Begin=0;Begin<Size();Begin+=16)
+        {
+            std::uint32_t n{std::min<std::uint32_t>(16,static_cast<std::uint32_t>(Size())-Begin)};
+            for(std::uint32_t i=0;i<n;++i)
+            {
+                h[i]=HashSymbol(Name(Begin+i));
+                std::size_t Group{(h[i]>>7)&GroupMask};
+                __builtin_prefetch(Control.data()+16*Group,1);
+                __builtin_prefetch(Slot.data()+16*Group,1);
+            };
+            for(std::uint32_t i=0;i<n;++i)Place(Begin+i,h[i]);
+        };
+    };
+};
+
+#endif
@@ -0,0 +1,120 @@
+#include"TopK.h"
+#include"ZeroCoupnBond.h"
+#include"VectorMath.h"
+#include<chrono>
+#include<random>
+double Seconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+};
+template<typename Function>
+double Time(Function&&Body)
+{
+    auto Start{std::chrono::steady_clock::now()};
+    Body();
+    return Seconds(Start);
+};
+//DV01 of a zero-coupon bond: the price change for a one basis point fall in its rate, P*T*1e-4.
+inline double Dv01(double FaceValue,double InterestRate,double YearFraction)
+{
+    return 1e-4*YearFraction*FaceValue*ExpSimd(-InterestRate*YearFraction);
+};
+//Reference ranking: nth_element on a copy, then sort the first K.
+std::vector<Ranked>Reference(const std::vector<double>&Key,std::size_t K)
+{
+    std::vector<Ranked>All(Key.size());
+    for(std::uint32_t i=0;i<Key.size();++i)All[i]={Key[i],i};
+    std::nth_element(All.begin(),All.begin()+K,All.end(),Ahead);
+    All.resize(K);
+    std::sort(All.begin(),All.end(),Ahead);
+    return All;
+};
+bool Same(const std::vector<Ranked>&a,const std::vector<Ranked>&b)
+{
+    return a.size()==b.size()&&std::equal(a.begin(),a.end(),b.begin(),[](const Ranked&x,const Ranked&y){return x.Id==y.Id&&x.Key==y.Key;});
+};
+int main()
+{
+    const std::size_t Count{10000000},K{100},Ticks{200},Moves{1000};
+    std::mt19937_64 Engine{47};
+    std::uniform_real_distribution<double>Rate{0.0,0.08},Years{0.1,30.0},Move{-5e-4,5e-4};
+    std::lognormal_distribution<double>Size{13.0,1.5};
+    std::vector<ZeroCouponStruct>Book(Count);
+    for(auto&Bond:Book)
+    {
+        Bond={Size(Engine),Rate(Engine),Years(Engine),0.0};
+        ZeroCouponBond(Bond);
+    };
+    std::vector<double>Risk(Count);
+    double Risking{Time([&]
+    {
+        #pragma omp simd
+        for(std::size_t i=0;i<Count;++i)Risk[i]=Dv01(Book[i].FaceValue,Book[i].InterestRate,Book[i].YearFraction);
+    })};
+    std::cout<<std::setprecision(4)<<Count<<" zero-coupon positions, top "<<K<<" by DV01 ("<<1e3*Risking<<" ms to compute the DV01s), "<<ThreadCount()<<" cores\n\n";
+
+    std::vector<Ranked>Expected;
+    double Nth{Time([&]{Expected=Reference(Risk,K);})};
+    std::vector<Ranked>Sorted(Count);
+    double Partial{Time([&]
+    {
+        for(std::uint32_t i=0;i<Count;++i)Sorted[i]={Risk[i],i};
+        std::partial_sort(Sorted.begin(),Sorted.begin()+K,Sorted.end(),Ahead);
+        Sorted.resize(K);
+    })};
+    std::vector<Ranked>One,All;
+    double Single{Time([&]{One=TopK(Risk.data(),Count,K,1);})};
+    double Threaded{Time([&]{All=TopK(Risk.data(),Count,K);})};
+    std::cout<<"full ranking                           ms    same as reference\n";
+    std::cout<<"nth_element + sort (reference) "<<std::setw(10)<<1e3*Nth<<"\n";
+    std::cout<<"partial_sort                   "<<std::setw(10)<<1e3*Partial<<std::setw(10)<<(Same(Sorted,Expected)?"yes":"NO")<<"\n";
+    std::cout<<"TopK, 1 thread                 "<<std::setw(10)<<1e3*Single<<std::setw(10)<<(Same(One,Expected)?"yes":"NO")<<"\n";
+    std::cout<<"TopK, "<<ThreadCount()<<" threads                "<<std::setw(10)<<1e3*Threaded<<std::setw(10)<<(Same(All,Expected)?"yes":"NO")<<"\n";
+    std::cout<<"largest DV01 "<<Expected.front().Key<<" (row "<<Expected.front().Id<<"), 100th "<<Expected.back().Key<<"\n\n";
+
+    //Ticks: each moves the rates of Moves random positions; the tracker takes the new DV01s and re-ranks,
+    //against repricing those positions and rescanning the whole book.
+    TopKTracker Tracker{K};
+    Tracker.Reset(Risk.data(),Count);
+    std::vector<std::uint32_t>Ids(Moves);
+    std::vector<double>Keys(Moves);
+    std::uniform_int_distribution<std::uint32_t>Row{0,static_cast<std::uint32_t>(Count-1)};
+    double Incremental{0.0},Rescan{0.0};
+    bool Agree{true};
+    for(std::size_t t=0;t<Ticks;++t)
+    {
+        for(std::size_t m=0;m<Moves;++m)
+        {
+            Ids[m]=Row(Engine);
+            //Every tenth tick also moves the current leaders, so some ticks knock the top set out.
+            if(t%10==9&&m<K)Ids[m]=Tracker.Top()[m].Id;
+            ZeroCouponStruct&Bond{Book[Ids[m]]};
+            Bond.InterestRate=std::max(0.0,Bond.InterestRate+(t%10==9&&m<K?0.05:Move(Engine)));
+            Keys[m]=Dv01(Bond.FaceValue,Bond.InterestRate,Bond.YearFraction);
+            Risk[Ids[m]]=Keys[m];
+        };
+        std::vector<Ranked>Top;
+        Incremental+=Time([&]
+        {
+            Tracker.Update(Ids.data(),Keys.data(),Moves);
+            Top=Tracker.Top();
+        });
+        Rescan+=Time([&]{All=TopK(Risk.data(),Count,K);});
+        Agree=Agree&&Same(Top,All);
+        if(t%50==0)Agree=Agree&&Same(Top,Reference(Risk,K));
+    };
+    std::cout<<Ticks<<" ticks of "<<Moves<<" changed positions\n";
+    std::cout<<"TopKTracker update + ranking   "<<std::setw(10)<<1e6*Incremental/Ticks<<" us per tick, "<<Tracker.Rebuilds-1<<" rebuilds\n";
+    std::cout<<"TopK rescan of the whole book  "<<std::setw(10)<<1e6*Rescan/Ticks<<" us per tick\n";
+    std::cout<<"same top "<<K<<" every tick: "<<(Agree?"yes":"NO")<<"\n";
+    return 0;
+};
+/*
+Ranks ten million zero-coupon positions by DV01 and keeps the top 100: nth_element and partial_sort as
+references, then the bounded-heap TopK on one and on all cores. A stream of ticks then moves a thousand
+positions each, and the incremental TopKTracker keeps the ranking against rescanning the book every tick;
+every tenth tick shocks the current leaders so that the tracker has to fall back to a rebuild.
+
+Build with
+g++ -std=c++20 -O3 -march=native -fopenmp-simd -fno-math-errno -pthread TopK.cc -o TopK
+*/
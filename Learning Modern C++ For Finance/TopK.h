@@ -0,0 +1,178 @@
+#ifndef TopK_H
+#define TopK_H
+#include<vector>
+#include<mutex>
+#include<limits>
+#include<algorithm>
+#include<cstdint>
+#include<cstddef>
+#include"Parallel.h"
+
+//One position in a ranking: its key (e.g. |DV01|) and its row.
+struct Ranked
+{
+    double Key;
+    std::uint32_t Id;
+};
+//Ranking order: larger key first, lower id first among equal keys, so every method returns the same list.
+inline bool Ahead(const Ranked&a,const Ranked&b){return a.Key>b.Key||(a.Key==b.Key&&a.Id<b.Id);};
+
+//The K largest of Key[0,Count), best first. GetMax of minMax.cc keeps the best of three; this keeps the best K
+//of a stream in a bounded min-heap whose root is the entry to beat. Each thread scans its chunk in blocks of
+//64: a branch-free max over the block vectorises, and once the heap is full a block whose max cannot beat
+//the root is skipped whole, which after the first few thousand rows is nearly every block. The per-thread
+//heaps are merged and sorted at the end.
+inline std::vector<Ranked>TopK(const double*Key,std::size_t Count,std::size_t K,unsigned Threads=ThreadCount())
+{
+    std::vector<Ranked>Best{};
+    if(K==0)return Best;
+    std::mutex Merge{};
+    ParallelFor(Count,[&](std::size_t Begin,std::size_t End)
+    {
+        constexpr std::size_t Block{64};
+        std::vector<Ranked>Heap{};
+        Heap.reserve(K);
+        for(std::size_t First=Begin;First<End;First+=Block)
+        {
+            std::size_t Last{std::min(End,First+Block)};
+            if(Heap.size()==K)
+            {
+                double Max{-std::numeric_limits<double>::infinity()};
+                #pragma omp simd reduction(max:Max)
+                for(std::size_t i=First;i<Last;++i)Max=std::max(Max,Key[i]);
+                //Rows come in increasing id, so an equal key loses to the root too.
+                if(Max<=Heap.front().Key)continue;
+            };
+            for(std::size_t i=First;i<Last;++i)
+            {
+                Ranked Entry{Key[i],static_cast<std::uint32_t>(i)};
+                if(Heap.size()<K)
+                {
+                    Heap.push_back(Entry);
+                    std::push_heap(Heap.begin(),Heap.end(),Ahead);
+                }else if(Ahead(Entry,Heap.front()))
+                {
+                    std::pop_heap(Heap.begin(),Heap.end(),Ahead);
+                    Heap.back()=Entry;
+                    std::push_heap(Heap.begin(),Heap.end(),Ahead);
+                };
+            };
+        };
+        std::lock_guard<std::mutex>Lock{Merge};
+        Best.insert(Best.end(),Heap.begin(),Heap.end());
+    },Threads,4096);
+    std::size_t Keep{std::min(K,Best.size())};
+    std::partial_sort(Best.begin(),Best.begin()+Keep,Best.end(),Ahead);
+    Best.resize(Keep);
+    return Best;
+};
+
+//Top K of a set of keys that changes a few rows at a time. Besides the keys it holds up to K+Slack
+//candidates and a Floor with every non-candidate's key at or below it. An updated candidate just takes its
+//new key; an updated non-candidate joins only if it rises above Floor, evicting the lowest candidate, whose
+//key then raises Floor. While at least K candidates stay above Floor, the top K of the candidates is the top
+//K of the book, so a tick costs its updates plus a sort of K+Slack entries. When candidates fall through
+//Floor (the old leaders all shrank) the candidates are rebuilt from a full TopK scan.
+class TopKTracker
+{
+public:
+    std::size_t Rebuilds{0};
+    explicit TopKTracker(std::size_t K,std::size_t Slack=0,unsigned Threads=ThreadCount())
+        :K{K},Capacity{K+(Slack?Slack:K)},Threads{Threads}{};
+    void Reset(const double*Key,std::size_t Count)
+    {
+        Keys.assign(Key,Key+Count);
+        Where.assign(Count,NotCandidate);
+        Rebuild();
+    };
+    void Update(std::uint32_t Id,double Key)
+    {
+        Keys[Id]=Key;
+        Dirty=true;
+        if(Where[Id]!=NotCandidate)
+        {
+            CandidateKey[Where[Id]]=Key;
+            return;
+        };
+        if(Key<=Floor)return;
+        std::uint32_t Slot{static_cast<std::uint32_t>(CandidateId.size())};
+        if(Slot<Capacity)
+        {
+            CandidateId.push_back(Id);
+            CandidateKey.push_back(Key);
+        }else
+        {
+            Slot=Lowest();
+            Floor=std::max(Floor,CandidateKey[Slot]);
+            Where[CandidateId[Slot]]=NotCandidate;
+            CandidateId[Slot]=Id;
+            CandidateKey[Slot]=Key;
+        };
+        Where[Id]=Slot;
+    };
+    void Update(const std::uint32_t*Ids,const double*Key,std::size_t Count)
+    {
+        for(std::size_t i=0;i<Count;++i)Update(Ids[i],Key[i]);
+    };
+    //The current top K, best first.
+    const std::vector<Ranked>&Top()
+    {
+        if(!Dirty)return Ranking;
+        std::size_t Above{0};
+        for(double Key:CandidateKey)Above+=Key>Floor;
+        if(Above<std::min(K,Keys.size()))Rebuild();
+        Ranking.clear();
+        for(std::size_t s=0;s<CandidateId.size();++s)Ranking.push_back({CandidateKey[s],CandidateId[s]});
+        std::size_t Keep{std::min(K,Ranking.size())};
+        std::partial_sort(Ranking.begin(),Ranking.begin()+Keep,Ranking.end(),Ahead);
+        Ranking.resize(Keep);
+        Dirty=false;
+        return Ranking;
+    };
+    const std::vector<double>&Key()const{return Keys;};
+private:
+    static constexpr std::uint32_t NotCandidate{0xFFFFFFFFu};
+    std::size_t K;
+    std::size_t Capacity;
+    unsigned Threads;
+    std::vector<double>Keys{};
+    std::vector<std::uint32_t>Where{};
+    std::vector<double>CandidateKey{};
+    std::vector<std::uint32_t>CandidateId{};
+    double Floor{-std::numeric_limits<double>::infinity()};
+    std::vector<Ranked>Ranking{};
+    bool Dirty{true};
+    //Candidates are the best Capacity rows; Floor is the next row's key, or -inf if every row is a candidate.
+    void Rebuild()
+    {
+        ++Rebuilds;
+        for(std::uint32_t Id:CandidateId)Where[Id]=NotCandidate;
+        std::vector<Ranked>Best{TopK(Keys.data(),Keys.size(),Capacity+1,Threads)};
+        Floor=-std::numeric_limits<double>::infinity();
+        if(Best.size()>Capacity)
+        {
+            Floor=Best.back().Key;
+            Best.pop_back();
+        };
+        CandidateKey.clear();
+        CandidateId.clear();
+        for(const Ranked&Entry:Best)
+        {
+            Where[Entry.Id]=static_cast<std::uint32_t>(CandidateId.size());
+            CandidateId.push_back(Entry.Id);
+            CandidateKey.push_back(Entry.Key);
+        };
+        Dirty=true;
+    };
+    //Slot of the lowest candidate key: a vectorised min, then a search for it.
+    std::uint32_t Lowest()const
+    {
+        const double*Key{CandidateKey.data()};
+        double Min{std::numeric_limits<double>::infinity()};
+        #pragma omp simd reduction(min:Min)
+        for(std::size_t s=0;s<CandidateKey.size();++s)Min=std::min(Min,Key[s]);
+        return static_cast<std::uint32_t>(std::find(CandidateKey.begin(),CandidateKey.end(),Min)-CandidateKey.begin());
+    };
+};
+
+#endif
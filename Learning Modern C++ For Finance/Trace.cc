@@ -0,0 +1,140 @@
+#include"Trace.h"
+#include"ImpliedVol.h"
+#include"Fourier.h"
+#include"PriceCache.h"
+#include"BinomialLattice.h"
+#include<random>
+#include<filesystem>
+double Seconds(std::chrono::steady_clock::time_point Start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now()-Start).count();
+};
+//A mixed intraday run: a zero-coupon book priced in chunks, a batch of implied volatilities, Heston strips
+//and cached American lattices. Returns a checksum so nothing is optimised away.
+double Workload()
+{
+    double Checksum{0.0};
+    std::vector<ZeroCouponStruct>Book(1000000);
+    for(std::size_t i=0;i<Book.size();++i)Book[i]={100.0,0.02+1e-9*i,0.5+i%60*0.5,0.0};
+    for(std::size_t Begin=0;Begin<Book.size();Begin+=4096)
+    {
+        TRACE_SCOPE("Zero-coupon chunk");
+        std::size_t End{std::min(Book.size(),Begin+4096)};
+        TRACE_COUNT("Zero-coupon pricings",End-Begin);
+        for(std::size_t i=Begin;i<End;++i)
+        {
+            ZeroCouponBond(Book[i]);
+            Checksum+=Book[i].Price;
+        };
+    };
+
+    OptionQuoteColumns Quotes{};
+    Quotes.Resize(200000);
+    for(std::size_t i=0;i<Quotes.Size();++i)
+    {
+        Quotes.Forward[i]=100.0;
+        Quotes.YearFraction[i]=0.1+(i%50)*0.1;
+        Quotes.Strike[i]=70.0+(i%61);
+        Quotes.Discount[i]=1.0;
+        Quotes.Theta[i]=i&1?1.0:-1.0;
+        Quotes.Price[i]=BlackPrice(100.0,Quotes.Strike[i],0.25*std::sqrt(Quotes.YearFraction[i]),Quotes.Theta[i]);
+    };
+    ImpliedVolatilityBatch(Quotes);
+    for(double v:Quotes.Volatility)Checksum+=v;
+
+    CarrMadanEngine<HestonStruct>Heston{{100.0,0.03,0.04,1.5,0.04,0.5,-0.7}};
+    std::vector<double>Strikes{},Strip{};
+    for(int s=0;s<=90;++s)Strikes.push_back(60.0+s);
+    for(int Repeat=0;Repeat<50;++Repeat)
+    {
+        for(double t:{0.25,0.5,1.0,2.0})
+        {
+            Heston.PriceStrip(t,Strikes,Strip);
+            Checksum+=Strip[45];
+        };
+    };
+
+    OptionCache Cache{4096};
+    std::mt19937_64 Engine{1};
+    for(int i=0;i<4000;++i)
+    {
+        OptionStruct Option{100.0,90.0+Engine()%21,0.03,1.0,0.2,1.0,0.0};
+        Checksum+=Cache.FindOrPrice({Option.Spot,Option.Strike,Option.InterestRate,Option.YearFraction,Option.Volatility,Option.Theta},
+            [&]{BinomialAmerican(Option,500);return Option.Price;});
+    };
+    return Checksum;
+};
+int main()
+{
+#ifdef FINANCE_TRACE
+    std::cout<<"Tracing compiled in\n";
+#else
+    std::cout<<"Tracing compiled out\n";
+#endif
+    Workload();
+    TraceRegistry::Get().Clear();
+    double Best{1e30},Checksum{0.0};
+    for(int Run=0;Run<5;++Run)
+    {
+        if(Run)TraceRegistry::Get().Clear();
+        auto Start{std::chrono::steady_clock::now()};
+        Checksum=Workload();
+        Best=std::min(Best,Seconds(Start));
+    };
+    std::cout<<std::setprecision(6)<<"Best of 5 workload runs : "<<1e3*Best<<" ms (checksum "<<Checksum<<")\n";
+
+    TraceRegistry&Registry{TraceRegistry::Get()};
+    std::cout<<"Events recorded : "<<Registry.Events()<<", dropped : "<<Registry.Dropped()<<"\n";
+    for(auto&[Name,Total]:Registry.MergedTotals())std::cout<<"  "<<Name<<" : "<<Total<<"\n";
+    std::filesystem::path Directory{std::filesystem::temp_directory_path()};
+    Registry.WriteChromeTrace(Directory/"Trace.json");
+    Registry.WriteBinaryTrace(Directory/"Trace.bin");
+    std::cout<<"Traces written to "<<(Directory/"Trace.json")<<" and "<<(Directory/"Trace.bin")<<"\n";
+
+    //Read the binary back and check it holds every event.
+    std::ifstream In{Directory/"Trace.bin",std::ios::binary};
+    char Magic[4];
+    std::uint32_t Version,Names,Threads;
+    double NanosecondsPerTick;
+    std::uint64_t StartTick,Stored{0};
+    In.read(Magic,4);
+    In.read(reinterpret_cast<char*>(&Version),4);
+    In.read(reinterpret_cast<char*>(&NanosecondsPerTick),8);
+    In.read(reinterpret_cast<char*>(&StartTick),8);
+    In.read(reinterpret_cast<char*>(&Names),4);
+    for(std::uint32_t n=0;n<Names;++n)
+    {
+        std::uint16_t Length;
+        In.read(reinterpret_cast<char*>(&Length),2);
+        In.ignore(Length);
+    };
+    In.read(reinterpret_cast<char*>(&Threads),4);
+    for(std::uint32_t t=0;t<Threads;++t)
+    {
+        std::uint32_t Id;
+        std::uint64_t Count;
+        In.read(reinterpret_cast<char*>(&Id),4);
+        In.read(reinterpret_cast<char*>(&Count),8);
+        In.ignore(Count*sizeof(TraceRegistry::BinaryEvent));
+        if(Id!=0xFFFFFFFF)Stored+=Count;
+    };
+    std::cout<<"Trace.bin : "<<std::string(Magic,4)<<" v"<<Version<<", "<<Names<<" names, "<<Stored<<" events, "
+        <<NanosecondsPerTick<<" ns per tick, intact : "<<(In&&Stored==Registry.Events()?"yes":"no")<<"\n";
+    //Cost of one scope, measured directly.
+    const int Scopes{100000};
+    auto Start{std::chrono::steady_clock::now()};
+    for(int i=0;i<Scopes;++i){TRACE_SCOPE("Empty scope");};
+    double PerScope{Seconds(Start)/Scopes*1e9};
+    std::cout<<"One TRACE_SCOPE : "<<PerScope<<" ns (two clock reads; rdtsc traps to the hypervisor on some VMs)\n";
+
+    return 0;
+};
+/*
+Runs a mixed pricing workload with the instrumentation in Trace.h, reports the cost of a scope and what was
+recorded, and writes Trace.json (load in chrome://tracing or ui.perfetto.dev) and Trace.bin to the temporary
+directory. Build it with and without -DFINANCE_TRACE to compare workload times; without it the macros vanish
+and nothing is recorded.
+
+Build with
+g++ -std=c++20 -O3 -march=native -fopenmp-simd -pthread -DFINANCE_TRACE Trace.cc -o Trace
+*/
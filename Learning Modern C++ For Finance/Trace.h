@@ -0,0 +1,301 @@
+#ifndef Trace_H
+#define Trace_H
+#include<atomic>
+#include<vector>
+#include<memory>
+#include<mutex>
+#include<string>
+#include<fstream>
+#include<iomanip>
+#include<chrono>
+#include<unordered_map>
+#include<algorithm>
+#include<cstring>
+#include<cstdint>
+#include<cstddef>
+#if defined(__x86_64__)||defined(__i386__)
+#include<x86intrin.h>
+#endif
+
+//Instrumentation for the pricers. With FINANCE_TRACE defined, TRACE_SCOPE("name") times the enclosing scope,
+//TRACE_VALUE("name",x) records a sample (e.g. a batch size) and TRACE_COUNT("name",n) adds to a running total
+//(e.g. pricing calls, cache hits). Each thread writes into its own fixed buffers with no locks: relaxed
+//stores of its counters and a release store of each buffer's size, so the registry can read them while the
+//thread runs; a full buffer drops events (or new total names) and counts them. Without FINANCE_TRACE the macros expand to nothing.
+//Names must be string literals: only the pointer is stored.
+enum class TraceKind:std::uint8_t{Scope,Value,Count};
+struct TraceEvent
+{
+    const char*Name;
+    std::uint64_t Start;
+    std::uint64_t End;
+    double Value;
+    TraceKind Kind;
+};
+inline std::uint64_t TraceClock()
+{
+#if defined(__x86_64__)||defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+};
+//A running total; only the owning thread stores to it.
+struct TraceTotal
+{
+    std::atomic<const char*>Name{nullptr};
+    std::atomic<double>Value{0.0};
+};
+struct TraceThread
+{
+    static constexpr std::size_t Capacity{1<<18};
+    static constexpr std::size_t TotalCapacity{64};
+    std::uint32_t Id{0};
+    std::unique_ptr<TraceEvent[]>Events{new TraceEvent[Capacity]};
+    std::atomic<std::size_t>Size{0};
+    std::atomic<std::size_t>Dropped{0};
+    TraceTotal Totals[TotalCapacity]{};
+    std::atomic<std::size_t>TotalNames{0};
+    void Drop()
+    {
+        Dropped.store(Dropped.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+    };
+    void Record(const TraceEvent&Event)
+    {
+        std::size_t n{Size.load(std::memory_order_relaxed)};
+        if(n==Capacity)
+        {
+            Drop();
+            return;
+        };
+        Events[n]=Event;
+        Size.store(n+1,std::memory_order_release);
+    };
+    void Value(const char*Name,double x)
+    {
+        std::uint64_t Now{TraceClock()};
+        Record({Name,Now,Now,x,TraceKind::Value});
+    };
+    //A handful of names per thread, so a linear search on the literal's address is cheapest.
+    void Count(const char*Name,double n)
+    {
+        std::size_t Used{TotalNames.load(std::memory_order_relaxed)};
+        for(std::size_t i=0;i<Used;++i)
+        {
+            if(Totals[i].Name.load(std::memory_order_relaxed)==Name)
+            {
+                Totals[i].Value.store(Totals[i].Value.load(std::memory_order_relaxed)+n,std::memory_order_relaxed);
+                return;
+            };
+        };
+        if(Used==TotalCapacity)
+        {
+            Drop();
+            return;
+        };
+        Totals[Used].Name.store(Name,std::memory_order_relaxed);
+        Totals[Used].Value.store(n,std::memory_order_relaxed);
+        TotalNames.store(Used+1,std::memory_order_release);
+    };
+};
+//Owns every thread's buffer (they outlive their threads) and the tick calibration.
+class TraceRegistry
+{
+public:
+    static TraceRegistry&Get()
+    {
+        static TraceRegistry Registry{};
+        return Registry;
+    };
+    TraceThread*Attach()
+    {
+        std::lock_guard<std::mutex>Lock{Mutex};
+        Threads.push_back(std::make_unique<TraceThread>());
+        Threads.back()->Id=static_cast<std::uint32_t>(Threads.size()-1);
+        return Threads.back().get();
+    };
+    //Drops everything recorded so far; call while the traced threads are idle.
+    void Clear()
+    {
+        std::lock_guard<std::mutex>Lock{Mutex};
+        for(auto&Thread:Threads)
+        {
+            Thread->Size.store(0,std::memory_order_release);
+            Thread->Dropped.store(0,std::memory_order_relaxed);
+            Thread->TotalNames.store(0,std::memory_order_release);
+        };
+    };
+    double NanosecondsPerTick()const
+    {
+        std::uint64_t Ticks{TraceClock()-StartTick};
+        double Nanoseconds{std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-StartTime).count()};
+        return Ticks?Nanoseconds/Ticks:1.0;
+    };
+    std::size_t Events()const
+    {
+        std::lock_guard<std::mutex>Lock{Mutex};
+        std::size_t Total{0};
+        for(auto&Thread:Threads)Total+=Thread->Size.load(std::memory_order_acquire);
+        return Total;
+    };
+    std::size_t Dropped()const
+    {
+        std::lock_guard<std::mutex>Lock{Mutex};
+        std::size_t Total{0};
+        for(auto&Thread:Threads)Total+=Thread->Dropped.load(std::memory_order_relaxed);
+        return Total;
+    };
+    //Chrome trace event format (chrome://tracing, Perfetto): scopes as complete events, samples and totals
+    //as counter events, timestamps in microseconds from the first trace call.
+    void WriteChromeTrace(const std::string&Path)const
+    {
+        std::lock_guard<std::mutex>Lock{Mutex};
+        double Scale{NanosecondsPerTick()*1e-3};
+        std::ofstream Out{Path};
+        Out<<std::fixed<<std::setprecision(3)<<"{\"traceEvents\":[\n";
+        bool First{true};
+        auto Separator=[&]{Out<<(First?"":",\n");First=false;};
+        std::uint64_t Last{0};
+        for(auto&Thread:Threads)
+        {
+            std::size_t n{Thread->Size.load(std::memory_order_acquire)};
+            for(std::size_t i=0;i<n;++i)
+            {
+                const TraceEvent&e{Thread->Events[i]};
+                double ts{(e.Start-StartTick)*Scale};
+                Last=std::max(Last,e.End);
+                Separator();
+                if(e.Kind==TraceKind::Scope)Out<<"{\"name\":\""<<e.Name<<"\",\"ph\":\"X\",\"pid\":0,\"tid\":"<<Thread->Id<<",\"ts\":"<<ts<<",\"dur\":"<<(e.End-e.Start)*Scale<<"}";
+                else Out<<"{\"name\":\""<<e.Name<<"\",\"ph\":\"C\",\"pid\":0,\"tid\":"<<Thread->Id<<",\"ts\":"<<ts<<",\"args\":{\"value\":"<<e.Value<<"}}";
+            };
+        };
+        for(auto&[Name,Total]:Merge())
+        {
+            Separator();
+            Out<<"{\"name\":\""<<Name<<"\",\"ph\":\"C\",\"pid\":0,\"tid\":0,\"ts\":"<<(Last-StartTick)*Scale<<",\"args\":{\"total\":"<<Total<<"}}";
+        };
+        Out<<"\n]}\n";
+    };
+    //Compact binary: "FTRC", version, ns per tick, name table, then per thread its events as
+    //(name index u32, kind u8, 3 pad bytes, start tick u64, end tick or value bits u64); totals follow as
+    //Count events of thread 0xFFFFFFFF.
+    void WriteBinaryTrace(const std::string&Path)const
+    {
+        std::lock_guard<std::mutex>Lock{Mutex};
+        std::vector<const char*>Names{};
+        std::unordered_map<const char*,std::uint32_t>Index{};
+        auto IndexOf=[&](const char*Name)
+        {
+            auto[Found,Inserted]{Index.emplace(Name,static_cast<std::uint32_t>(Names.size()))};
+            if(Inserted)Names.push_back(Name);
+            return Found->second;
+        };
+        std::vector<std::vector<BinaryEvent>>PerThread(Threads.size()+1);
+        for(std::size_t t=0;t<Threads.size();++t)
+        {
+            std::size_t n{Threads[t]->Size.load(std::memory_order_acquire)};
+            for(std::size_t i=0;i<n;++i)
+            {
+                const TraceEvent&e{Threads[t]->Events[i]};
+                std::uint64_t Second{e.Kind==TraceKind::Scope?e.End:Bits(e.Value)};
+                PerThread[t].push_back({IndexOf(e.Name),static_cast<std::uint8_t>(e.Kind),{},e.Start,Second});
+            };
+        };
+        std::uint64_t Now{TraceClock()};
+        for(auto&[Name,Total]:Merge())PerThread.back().push_back({IndexOf(Name),static_cast<std::uint8_t>(TraceKind::Count),{},Now,Bits(Total)});
+        std::ofstream Out{Path,std::ios::binary};
+        auto Put=[&](const auto&x){Out.write(reinterpret_cast<const char*>(&x),sizeof x);};
+        Out.write("FTRC",4);
+        Put(std::uint32_t{1});
+        Put(NanosecondsPerTick());
+        Put(StartTick);
+        Put(static_cast<std::uint32_t>(Names.size()));
+        for(const char*Name:Names)
+        {
+            auto Length{static_cast<std::uint16_t>(std::strlen(Name))};
+            Put(Length);
+            Out.write(Name,Length);
+        };
+        Put(static_cast<std::uint32_t>(PerThread.size()));
+        for(std::size_t t=0;t<PerThread.size();++t)
+        {
+            Put(t<Threads.size()?Threads[t]->Id:std::uint32_t{0xFFFFFFFF});
+            Put(static_cast<std::uint64_t>(PerThread[t].size()));
+            Out.write(reinterpret_cast<const char*>(PerThread[t].data()),PerThread[t].size()*sizeof(BinaryEvent));
+        };
+    };
+    std::vector<std::pair<const char*,double>>MergedTotals()const
+    {
+        std::lock_guard<std::mutex>Lock{Mutex};
+        return Merge();
+    };
+    struct BinaryEvent
+    {
+        std::uint32_t Name;
+        std::uint8_t Kind;
+        std::uint8_t Pad[3];
+        std::uint64_t Start;
+        std::uint64_t Second;
+    };
+private:
+    TraceRegistry():StartTick{TraceClock()},StartTime{std::chrono::steady_clock::now()}{};
+    //Totals of every thread, merged by name; called with Mutex held.
+    std::vector<std::pair<const char*,double>>Merge()const
+    {
+        std::vector<std::pair<const char*,double>>Merged{};
+        for(auto&Thread:Threads)
+        {
+            std::size_t Used{Thread->TotalNames.load(std::memory_order_acquire)};
+            for(std::size_t i=0;i<Used;++i)
+            {
+                const char*Name{Thread->Totals[i].Name.load(std::memory_order_relaxed)};
+                double Total{Thread->Totals[i].Value.load(std::memory_order_relaxed)};
+                auto Found{std::find_if(Merged.begin(),Merged.end(),[&](auto&m){return std::strcmp(m.first,Name)==0;})};
+                if(Found==Merged.end())Merged.emplace_back(Name,Total);
+                else Found->second+=Total;
+            };
+        };
+        return Merged;
+    };
+    static std::uint64_t Bits(double x)
+    {
+        std::uint64_t b;
+        std::memcpy(&b,&x,sizeof b);
+        return b;
+    };
+    mutable std::mutex Mutex;
+    std::vector<std::unique_ptr<TraceThread>>Threads;
+    std::uint64_t StartTick;
+    std::chrono::steady_clock::time_point StartTime;
+};
+inline TraceThread&ThisTraceThread()
+{
+    thread_local TraceThread*Current{nullptr};
+    if(!Current)Current=TraceRegistry::Get().Attach();
+    return *Current;
+};
+//Attaches the thread before reading the clock, so even the first scope starts after the registry's StartTick.
+class TraceScope
+{
+public:
+    explicit TraceScope(const char*Name):Thread{ThisTraceThread()},Name{Name},Start{TraceClock()}{};
+    ~TraceScope(){Thread.Record({Name,Start,TraceClock(),0.0,TraceKind::Scope});};
+private:
+    TraceThread&Thread;
+    const char*Name;
+    std::uint64_t Start;
+};
+
+#ifdef FINANCE_TRACE
+#define TRACE_JOIN_(a,b) a##b
+#define TRACE_JOIN(a,b) TRACE_JOIN_(a,b)
+#define TRACE_SCOPE(Name) TraceScope TRACE_JOIN(TraceScope_,__LINE__){Name}
+#define TRACE_VALUE(Name,x) ThisTraceThread().Value(Name,static_cast<double>(x))
+#define TRACE_COUNT(Name,n) ThisTraceThread().Count(Name,static_cast<double>(n))
+#else
+#define TRACE_SCOPE(Name) static_cast<void>(0)
+#define TRACE_VALUE(Name,x) static_cast<void>(0)
+#define TRACE_COUNT(Name,n) static_cast<void>(0)
+#endif
+
+#endif
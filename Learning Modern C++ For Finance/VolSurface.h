@@ -0,0 +1,308 @@
+#ifndef VolSurface_H
+#define VolSurface_H
+#include<vector>
+#include<array>
+#include<cmath>
+#include<algorithm>
+#include<cstddef>
+#include"VectorMath.h"
+#include"NelderMead.h"
+#include"Parallel.h"
+
+//Market smile at one expiry: Black volatilities by strike, and the forward they were quoted against.
+struct SmileQuotes
+{
+    double Expiry;
+    double Forward;
+    std::vector<double>Strike;
+    std::vector<double>Volatility;
+};
+//Raw SVI total variance w(k)=A+B(Rho(k-M)+sqrt((k-M)^2+Sigma^2)) in log-moneyness k=ln(K/F).
+struct SviSlice
+{
+    double A;
+    double B;
+    double Rho;
+    double M;
+    double Sigma;
+};
+//SABR with Hagan's lognormal expansion; Beta is fixed and not calibrated.
+struct SabrSlice
+{
+    double Alpha;
+    double Beta;
+    double Rho;
+    double Nu;
+};
+enum class SliceModel{Svi,Sabr};
+
+#pragma omp declare simd notinbranch
+inline double SviVariance(double A,double B,double Rho,double M,double Sigma,double k)
+{
+    double x{k-M};
+    return A+B*(Rho*x+std::sqrt(x*x+Sigma*Sigma));
+};
+//Total variance sigma_B^2 T of a SABR slice with expiry T at k=ln(K/F); ForwardPower is F^(1-Beta). z/x(z)
+//is replaced by its expansion at the money.
+#pragma omp declare simd notinbranch
+inline double SabrVariance(double Alpha,double Beta,double Rho,double Nu,double ForwardPower,double T,double k)
+{
+    double Exponent{1.0-Beta};
+    double Scale{ForwardPower*ExpSimd(0.5*Exponent*k)};
+    double e2{Exponent*Exponent};
+    double k2{k*k};
+    double Denominator{Scale*(1.0+e2/24.0*k2+e2*e2/1920.0*k2*k2)};
+    double z{-Nu/Alpha*Scale*k};
+    double xz{LogSimd((std::sqrt(1.0-2.0*Rho*z+z*z)+z-Rho)/(1.0-Rho))};
+    //Blended with a 0/1 weight rather than selected, which GCC would turn back into a branch around the log.
+    double Money{static_cast<double>(std::abs(z)<1e-7)};
+    double Quotient{(z+Money)/(xz+Money)};
+    double Ratio{Quotient+Money*(1.0-0.5*Rho*z-Quotient)};
+    double Correction{1.0+(e2/24.0*Alpha*Alpha/(Scale*Scale)+0.25*Rho*Beta*Nu*Alpha/Scale+(2.0-3.0*Rho*Rho)/24.0*Nu*Nu)*T};
+    double Volatility{Alpha/Denominator*Ratio*Correction};
+    return Volatility*Volatility*T;
+};
+
+//Quasi-explicit SVI fit (Zeliade): for fixed (M,Sigma) the total variance is linear in (A,D,C) with
+//D=Rho B Sigma and C=B Sigma, so it is solved by least squares and clamped to the no-arbitrage box
+//0<=C<=4Sigma, |D|<=min(C,4Sigma-C), 0<=A<=max w. Only (M,log Sigma) is left to the simplex.
+//Previous, when given, is the warm start. Error receives the RMS volatility error.
+inline SviSlice CalibrateSvi(const SmileQuotes&Quotes,const SviSlice*Previous,double&Error)
+{
+    const std::size_t n{Quotes.Strike.size()};
+    std::vector<double>k(n),w(n);
+    double MaxVariance{0.0};
+    for(std::size_t i=0;i<n;++i)
+    {
+        k[i]=std::log(Quotes.Strike[i]/Quotes.Forward);
+        w[i]=Quotes.Volatility[i]*Quotes.Volatility[i]*Quotes.Expiry;
+        MaxVariance=std::max(MaxVariance,w[i]);
+    };
+    auto Inner=[&](double M,double Sigma)
+    {
+        //Normal equations for (A,D,C) against the regressors 1, y, sqrt(y^2+1).
+        double S1{0},Sy{0},Sz{0},Syy{0},Syz{0},Szz{0},Sw{0},Syw{0},Szw{0};
+        for(std::size_t i=0;i<n;++i)
+        {
+            double y{(k[i]-M)/Sigma};
+            double z{std::sqrt(y*y+1.0)};
+            S1+=1.0;Sy+=y;Sz+=z;Syy+=y*y;Syz+=y*z;Szz+=z*z;Sw+=w[i];Syw+=y*w[i];Szw+=z*w[i];
+        };
+        double Det{S1*(Syy*Szz-Syz*Syz)-Sy*(Sy*Szz-Syz*Sz)+Sz*(Sy*Syz-Syy*Sz)};
+        double A{(Sw*(Syy*Szz-Syz*Syz)-Sy*(Syw*Szz-Syz*Szw)+Sz*(Syw*Syz-Syy*Szw))/Det};
+        double D{(S1*(Syw*Szz-Szw*Syz)-Sw*(Sy*Szz-Syz*Sz)+Sz*(Sy*Szw-Syw*Sz))/Det};
+        double C{(S1*(Syy*Szw-Syz*Syw)-Sy*(Sy*Szw-Syw*Sz)+Sw*(Sy*Syz-Syy*Sz))/Det};
+        if(!std::isfinite(A+D+C))A=D=C=0.0;
+        C=std::clamp(C,0.0,4.0*Sigma);
+        double Bound{std::min(C,4.0*Sigma-C)};
+        D=std::clamp(D,-Bound,Bound);
+        //A is refitted to what the clamps left over.
+        A=0.0;
+        for(std::size_t i=0;i<n;++i)
+        {
+            double y{(k[i]-M)/Sigma};
+            A+=w[i]-D*y-C*std::sqrt(y*y+1.0);
+        };
+        A=std::clamp(A/n,0.0,MaxVariance);
+        return SviSlice{A,C/Sigma,C>0.0?D/C:0.0,M,Sigma};
+    };
+    auto SquaredError=[&](const SviSlice&s)
+    {
+        double Sum{0.0};
+        for(std::size_t i=0;i<n;++i)
+        {
+            double r{SviVariance(s.A,s.B,s.Rho,s.M,s.Sigma,k[i])-w[i]};
+            Sum+=r*r;
+        };
+        return Sum;
+    };
+    auto Objective=[&](const std::array<double,2>&x){return SquaredError(Inner(x[0],std::exp(x[1])));};
+    std::array<double,2>Start{Previous?Previous->M:0.0,std::log(Previous?Previous->Sigma:0.1)};
+    double Value;
+    std::array<double,2>x{NelderMead(Objective,Start,Previous?0.02:0.2,Previous?150:500,1e-12,Value)};
+    SviSlice Slice{Inner(x[0],std::exp(x[1]))};
+    Error=0.0;
+    for(std::size_t i=0;i<n;++i)
+    {
+        double r{std::sqrt(std::max(SviVariance(Slice.A,Slice.B,Slice.Rho,Slice.M,Slice.Sigma,k[i]),0.0)/Quotes.Expiry)-Quotes.Volatility[i]};
+        Error+=r*r;
+    };
+    Error=std::sqrt(Error/n);
+    return Slice;
+};
+//SABR fit in volatility space over (log Alpha, atanh Rho, log Nu), which keeps the simplex unconstrained.
+inline SabrSlice CalibrateSabr(const SmileQuotes&Quotes,double Beta,const SabrSlice*Previous,double&Error)
+{
+    const std::size_t n{Quotes.Strike.size()};
+    std::vector<double>k(n);
+    for(std::size_t i=0;i<n;++i)k[i]=std::log(Quotes.Strike[i]/Quotes.Forward);
+    double ForwardPower{std::pow(Quotes.Forward,1.0-Beta)};
+    auto Slice=[&](const std::array<double,3>&x){return SabrSlice{std::exp(x[0]),Beta,std::tanh(x[1]),std::exp(x[2])};};
+    auto SquaredError=[&](const SabrSlice&s)
+    {
+        double Sum{0.0};
+        for(std::size_t i=0;i<n;++i)
+        {
+            double r{std::sqrt(std::max(SabrVariance(s.Alpha,s.Beta,s.Rho,s.Nu,ForwardPower,Quotes.Expiry,k[i]),0.0)/Quotes.Expiry)-Quotes.Volatility[i]};
+            Sum+=r*r;
+        };
+        return Sum;
+    };
+    std::array<double,3>Start{};
+    if(Previous)Start={std::log(Previous->Alpha),std::atanh(Previous->Rho),std::log(Previous->Nu)};
+    else{
+        //The quote nearest the money sets the level.
+        std::size_t Money{0};
+        for(std::size_t i=1;i<n;++i)if(std::abs(k[i])<std::abs(k[Money]))Money=i;
+        Start={std::log(Quotes.Volatility[Money]*ForwardPower),0.0,std::log(0.5)};
+    };
+    double Value;
+    std::array<double,3>x{NelderMead([&](const std::array<double,3>&x){return SquaredError(Slice(x));},Start,Previous?0.05:0.3,Previous?200:600,1e-12,Value)};
+    Error=std::sqrt(Value/n);
+    return Slice(x);
+};
+
+//Implied volatility surface from one calibrated slice per expiry. Between expiries total variance is linear
+//in T at fixed log-moneyness against the interpolated forward; before the first and after the last expiry
+//it scales with T. Build() turns that into per-interval weights a_L=cL0+cL1 T, a_U=cU0+cU1 T on the slices
+//either side, so a lookup is a bucket read, one comparison, gathers and two slice evaluations.
+struct VolSurface
+{
+    SliceModel Model;
+    double Spot;
+    double SabrBeta{1.0};
+    std::vector<double>Expiry{};
+    std::vector<double>Forward{};
+    std::vector<SviSlice>Svi{};
+    std::vector<SabrSlice>Sabr{};
+    std::vector<double>Error{};
+    //Per interval j=0..N (j = number of expiries before T): slice parameters either side, the log-forward
+    //offsets ln(F/S) either side, and the weight coefficients.
+    std::array<std::vector<double>,6>Lower{},Upper{};
+    std::vector<double>LowerOffset{},UpperOffset{};
+    std::vector<double>LowerBase{},LowerSlope{},UpperBase{},UpperSlope{};
+    //Uniform buckets in T no wider than the closest pair of expiries, each holding the interval at its left
+    //edge; at most one expiry falls inside a bucket, so one comparison against Knot (the expiries followed
+    //by +infinity) finishes the search.
+    std::vector<int>Bucket{};
+    std::vector<double>Knot{};
+    double BucketScale{0.0};
+
+    //Fits every slice in parallel, warm-started from the current slices when the expiries are unchanged,
+    //then rebuilds the interpolation coefficients. Quotes must be sorted by expiry.
+    void Calibrate(const std::vector<SmileQuotes>&Quotes,unsigned Threads=ThreadCount())
+    {
+        const std::size_t Slices{Quotes.size()};
+        bool Warm{Expiry.size()==Slices&&(Model==SliceModel::Svi?Svi.size():Sabr.size())==Slices};
+        for(std::size_t s=0;Warm&&s<Slices;++s)Warm=Expiry[s]==Quotes[s].Expiry;
+        Expiry.resize(Slices);
+        Forward.resize(Slices);
+        Error.resize(Slices);
+        if(Model==SliceModel::Svi)Svi.resize(Slices);
+        else Sabr.resize(Slices);
+        ParallelFor(Slices,[&](std::size_t Begin,std::size_t End)
+        {
+            for(std::size_t s=Begin;s<End;++s)
+            {
+                Expiry[s]=Quotes[s].Expiry;
+                Forward[s]=Quotes[s].Forward;
+                if(Model==SliceModel::Svi)Svi[s]=CalibrateSvi(Quotes[s],Warm?&Svi[s]:nullptr,Error[s]);
+                else Sabr[s]=CalibrateSabr(Quotes[s],SabrBeta,Warm?&Sabr[s]:nullptr,Error[s]);
+            };
+        },Threads,1);
+        Build();
+    };
+    void Build()
+    {
+        const std::size_t N{Expiry.size()};
+        for(auto*Column:{&LowerOffset,&UpperOffset,&LowerBase,&LowerSlope,&UpperBase,&UpperSlope})Column->assign(N+1,0.0);
+        for(std::size_t p=0;p<6;++p)
+        {
+            Lower[p].assign(N+1,0.0);
+            Upper[p].assign(N+1,0.0);
+        };
+        auto Copy=[&](std::array<std::vector<double>,6>&Side,std::vector<double>&Offset,std::size_t j,std::size_t s)
+        {
+            std::array<double,6>p{};
+            if(Model==SliceModel::Svi)p={Svi[s].A,Svi[s].B,Svi[s].Rho,Svi[s].M,Svi[s].Sigma,0.0};
+            else p={Sabr[s].Alpha,Sabr[s].Beta,Sabr[s].Rho,Sabr[s].Nu,std::pow(Forward[s],1.0-Sabr[s].Beta),Expiry[s]};
+            for(std::size_t q=0;q<6;++q)Side[q][j]=p[q];
+            Offset[j]=std::log(Forward[s]/Spot);
+        };
+        double Gap{Expiry[0]};
+        for(std::size_t s=1;s<N;++s)Gap=std::min(Gap,Expiry[s]-Expiry[s-1]);
+        BucketScale=1.0/Gap;
+        Bucket.resize(static_cast<std::size_t>(Expiry[N-1]*BucketScale)+2);
+        for(std::size_t b=0;b<Bucket.size();++b)
+        {
+            double Edge{b/BucketScale};
+            Bucket[b]=static_cast<int>(std::count_if(Expiry.begin(),Expiry.end(),[&](double T){return T<Edge;}));
+        };
+        Knot=Expiry;
+        Knot.push_back(HUGE_VAL);
+        for(std::size_t j=0;j<=N;++j)
+        {
+            //The ends use one slice on both sides with zero lower weight, so every lane reads valid parameters.
+            std::size_t l{j==0?0:j-1},u{j==N?N-1:j};
+            Copy(Lower,LowerOffset,j,l);
+            Copy(Upper,UpperOffset,j,u);
+            if(j==0||j==N)UpperSlope[j]=1.0/Expiry[u];
+            else{
+                double Width{Expiry[u]-Expiry[l]};
+                LowerBase[j]=Expiry[u]/Width;
+                LowerSlope[j]=-1.0/Width;
+                UpperBase[j]=-Expiry[l]/Width;
+                UpperSlope[j]=1.0/Width;
+            };
+        };
+    };
+    //Batched lookup over (strike, expiry) columns; expiries must be positive. The model is switched once
+    //per call and the loop body is straight-line code, so with -fno-math-errno it vectorises with gathers. A bucket edge that
+    //rounds onto an expiry is harmless, as both intervals either side give that slice's variance there.
+    template<SliceModel Kind>
+    void Lookup(const double*Strike,const double*Maturity,std::size_t Count,double*Out)const
+    {
+        const int*Start{Bucket.data()};
+        const double*T{Knot.data()};
+        const double Last{static_cast<double>(Bucket.size()-1)};
+        const double LogSpot{std::log(Spot)};
+        const double*L0{Lower[0].data()},*L1{Lower[1].data()},*L2{Lower[2].data()},*L3{Lower[3].data()},*L4{Lower[4].data()},*L5{Lower[5].data()};
+        const double*U0{Upper[0].data()},*U1{Upper[1].data()},*U2{Upper[2].data()},*U3{Upper[3].data()},*U4{Upper[4].data()},*U5{Upper[5].data()};
+        const double*XL{LowerOffset.data()},*XU{UpperOffset.data()};
+        const double*LB{LowerBase.data()},*LS{LowerSlope.data()},*UB{UpperBase.data()},*US{UpperSlope.data()};
+        #pragma omp simd
+        for(std::size_t i=0;i<Count;++i)
+        {
+            double t{Maturity[i]};
+            int j{Start[static_cast<int>(std::min(t*BucketScale,Last))]};
+            j+=T[j]<t;
+            double WeightL{LB[j]+LS[j]*t},WeightU{UB[j]+US[j]*t};
+            double k{LogSimd(Strike[i])-LogSpot-WeightL*XL[j]-WeightU*XU[j]};
+            double w;
+            if constexpr(Kind==SliceModel::Svi)w=WeightL*SviVariance(L0[j],L1[j],L2[j],L3[j],L4[j],k)+WeightU*SviVariance(U0[j],U1[j],U2[j],U3[j],U4[j],k);
+            else w=WeightL*SabrVariance(L0[j],L1[j],L2[j],L3[j],L4[j],L5[j],k)+WeightU*SabrVariance(U0[j],U1[j],U2[j],U3[j],U4[j],U5[j],k);
+            Out[i]=std::sqrt(std::max(w,0.0)/t);
+        };
+    };
+    void Volatility(const double*Strike,const double*Maturity,std::size_t Count,double*Out)const
+    {
+        if(Model==SliceModel::Svi)Lookup<SliceModel::Svi>(Strike,Maturity,Count,Out);
+        else Lookup<SliceModel::Sabr>(Strike,Maturity,Count,Out);
+    };
+    void Volatility(const std::vector<double>&Strike,const std::vector<double>&Maturity,std::vector<double>&Out,unsigned Threads=ThreadCount())const
+    {
+        Out.resize(Strike.size());
+        ParallelFor(Strike.size(),[&](std::size_t Begin,std::size_t End)
+        {
+            Volatility(Strike.data()+Begin,Maturity.data()+Begin,End-Begin,Out.data()+Begin);
+        },Threads);
+    };
+    double Volatility(double Strike,double Maturity)const
+    {
+        double Out;
+        Volatility(&Strike,&Maturity,1,&Out);
+        return Out;
+    };
+};
+
+#endif